@@ -0,0 +1,234 @@
+#include "daemon.hpp"
+#include "exporter.hpp"
+#include "project.hpp"
+
+#include <QApplication>
+#include <QClipboard>
+#include <QMimeData>
+#include <QCursor>
+#include <QScreen>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <stdio.h>
+#include <stdlib.h>
+
+QString daemonSocketName()
+{
+  QString user = QString::fromLocal8Bit(qgetenv("USER"));
+  if (user.isEmpty()) user = QString::fromLocal8Bit(qgetenv("USERNAME"));
+
+  return QString(DAEMON_SOCKET_NAME) + "-" + user;
+}
+
+ZoomDaemon::ZoomDaemon(const DaemonConfig config) : QObject(), _config(config), _widget(nullptr)
+{
+  _server.setSocketOptions(QLocalServer::UserAccessOption);
+  connect(&_server, &QLocalServer::newConnection, this, &ZoomDaemon::acceptConnection);
+
+  prepareWidget();
+}
+
+ZoomDaemon::~ZoomDaemon()
+{
+  delete _widget;
+}
+
+bool ZoomDaemon::listen()
+{
+  // Remove the socket left by a daemon that crashed
+  QLocalServer::removeServer(daemonSocketName());
+
+  if (!_server.listen(daemonSocketName())) {
+    fprintf(stderr, "[ERROR] Couldn't create the socket of the daemon: %s\n", QSTRING_TO_STRING(_server.errorString()));
+    return false;
+  }
+
+  fprintf(stdout, "[INFO] Daemon listening on: %s\n", QSTRING_TO_STRING(_server.fullServerName()));
+  return true;
+}
+
+void ZoomDaemon::prepareWidget()
+{
+  _widget = new ZoomWidget;
+  if (_config.floating) {
+    _widget->setWindowFlags(Qt::WindowMinimizeButtonHint | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint | Qt::BypassWindowManagerHint);
+  } else {
+    _widget->setWindowFlags(Qt::WindowMinimizeButtonHint);
+  }
+  _widget->setCursor(QCursor(Qt::CrossCursor));
+  _widget->initFileConfig(_config.savePath, _config.saveName, _config.imgExt, _config.vidExt, _config.clipExt, _config.exportScale);
+
+  // Do now what would be done before the first frame
+  _widget->applyFonts();
+
+  connect(_widget, &ZoomWidget::quitRequested, this, &ZoomDaemon::finishSession);
+}
+
+void ZoomDaemon::acceptConnection()
+{
+  while (_server.hasPendingConnections()) {
+    QLocalSocket *socket = _server.nextPendingConnection();
+    connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readRequest(socket); });
+  }
+}
+
+void ZoomDaemon::readRequest(QLocalSocket *socket)
+{
+  QDataStream in(socket);
+  QList<QString> args;
+
+  // Wait for the whole request
+  in.startTransaction();
+  in >> args;
+  if (!in.commitTransaction()) {
+    return;
+  }
+
+  const QString error = activate(args);
+  if (!error.isEmpty()) {
+    fprintf(stderr, "[ERROR] Trigger rejected: %s\n", QSTRING_TO_STRING(error));
+  }
+
+  QDataStream out(socket);
+  out << error;
+  socket->flush();
+  socket->disconnectFromServer();
+}
+
+QString ZoomDaemon::activate(const QList<QString> args)
+{
+  if (_widget->isVisible()) {
+    return "ZoomMe is already being used";
+  }
+
+  // Validate everything before touching the widget (the widget exits the app
+  // when it can't load the background, and the daemon should keep running)
+  QString mode = (args.isEmpty()) ? QString() : args.first();
+  QImage image;
+  QSize fullImageSize;
+  QSize blackboardSize;
+  QScreen *screen = QApplication::screenAt(QCursor::pos());
+
+  if (mode == "-i") {
+    if (args.size() != 2) return "Usage: -i <image_path>";
+    if (args.at(1) == STDIO_PATH) return "The daemon can't read the image from the standard input of the trigger";
+    image = readImagePreview(args.at(1), screen->geometry().size() * screen->devicePixelRatio() * IMAGE_PREVIEW_SCALE, &fullImageSize);
+    if (image.isNull()) return "Couldn't open the image: " + args.at(1);
+
+  } else if (mode == "-c") {
+    if (args.size() != 1) return "Usage: -c";
+    const QMimeData *mimeData = QApplication::clipboard()->mimeData();
+    if (!mimeData || clipboardImageFormat(mimeData->formats()).isEmpty()) {
+      return "The clipboard doesn't contain an image or its format is not supported";
+    }
+
+  } else if (mode == "-r") {
+    if (args.size() != 2) return "Usage: -r <file.zoomme>";
+    if (QFileInfo(args.at(1)).suffix() != "zoomme") return "It's not a '.zoomme' file: " + args.at(1);
+
+    // The project is read once, by the widget (it doesn't change the widget
+    // if the file is corrupted)
+    QFile file(args.at(1));
+    if (!file.open(QIODevice::ReadOnly) || !isProjectHeaderValid(&file)) {
+      return "The file is corrupted or it's not a ZoomMe file: " + args.at(1);
+    }
+
+  } else if (mode == "--empty") {
+    if (args.size() != 3) return "Usage: --empty <width> <height>";
+    bool widthCorrect = false, heightCorrect = false;
+    blackboardSize = QSize(args.at(1).toInt(&widthCorrect), args.at(2).toInt(&heightCorrect));
+    if (!widthCorrect || !heightCorrect || blackboardSize.isEmpty()) return "The given size is not valid";
+
+  } else if (mode == "-l") {
+    if (args.size() != 1) return "Usage: -l";
+
+  } else if (mode == "--all-screens") {
+    if (args.size() != 1) return "Usage: --all-screens";
+
+  } else if (!mode.isEmpty()) {
+    return "Unknown mode: " + mode;
+  }
+
+  _widget->resize(screen->geometry().size());
+  _widget->move(screen->geometry().topLeft());
+
+  if (mode == "-i") {
+    _widget->grabImage(QPixmap::fromImage(image));
+    if (fullImageSize.isValid()) _widget->setImageDetail(args.at(1), fullImageSize);
+  } else if (mode == "-c") {
+    const QString error = _widget->grabFromClipboard();
+    if (!error.isEmpty()) return error;
+  } else if (mode == "-r") {
+    if (!_widget->restoreStateFromFile(args.at(1))) {
+      return "The file is corrupted or it's not a ZoomMe file: " + args.at(1);
+    }
+  } else if (mode == "--empty") {
+    _widget->createBlackboard(blackboardSize);
+  } else if (mode == "--all-screens") {
+    const QString error = _widget->grabAllScreens();
+    if (!error.isEmpty()) return error;
+  } else if (mode == "-l") {
+    _widget->setAttribute(Qt::WA_TranslucentBackground, true);
+    _widget->setLiveMode();
+  } else {
+    const QString error = _widget->grabDesktop();
+    if (!error.isEmpty()) return error;
+  }
+
+  QApplication::beep();
+  _widget->show();
+  _widget->raise();
+  _widget->activateWindow();
+  return QString();
+}
+
+void ZoomDaemon::finishSession()
+{
+  // Prepare a clean widget for the next trigger (the old one waits for its
+  // exports when it's deleted)
+  _widget->hide();
+  _widget->deleteLater();
+  prepareWidget();
+}
+
+int triggerDaemon(const QList<QString> args)
+{
+  QLocalSocket socket;
+  socket.connectToServer(daemonSocketName());
+  if (!socket.waitForConnected(DAEMON_TIMEOUT)) {
+    fprintf(stderr, "[ERROR] Couldn't connect to the daemon (is 'zoomme --daemon' running?): %s\n", QSTRING_TO_STRING(socket.errorString()));
+    return EXIT_FAILURE;
+  }
+
+  QDataStream out(&socket);
+  out << args;
+  if (!socket.waitForBytesWritten(DAEMON_TIMEOUT)) {
+    fprintf(stderr, "[ERROR] Couldn't send the request to the daemon: %s\n", QSTRING_TO_STRING(socket.errorString()));
+    return EXIT_FAILURE;
+  }
+
+  // Wait for the reply
+  QDataStream in(&socket);
+  QString error;
+  while (true) {
+    in.startTransaction();
+    in >> error;
+    if (in.commitTransaction()) {
+      break;
+    }
+
+    if (!socket.waitForReadyRead(DAEMON_TIMEOUT)) {
+      fprintf(stderr, "[ERROR] The daemon didn't reply: %s\n", QSTRING_TO_STRING(socket.errorString()));
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!error.isEmpty()) {
+    fprintf(stderr, "[ERROR] %s\n", QSTRING_TO_STRING(error));
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
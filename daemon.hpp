@@ -0,0 +1,67 @@
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+#include "zoomwidget.hpp"
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QList>
+#include <QString>
+
+// Name of the local socket (the name of the user is appended to it)
+#define DAEMON_SOCKET_NAME "zoomme"
+// Maximum time that the client waits for the daemon
+#define DAEMON_TIMEOUT 3000 // msec
+
+// Settings of the widgets created by the daemon (the configuration flags
+// given with --daemon)
+struct DaemonConfig {
+  QString savePath;
+  QString saveName;
+  QString imgExt;
+  QString vidExt;
+  QString clipExt;
+  int exportScale;
+  bool floating;
+};
+
+// Keeps the application running with a hidden widget that is already created
+// (with the fonts, the buttons and the tool bar ready), so when it's triggered
+// it only has to grab the background and show it. When the user exits, the
+// widget is destroyed and a new one is prepared for the next trigger.
+//
+// The protocol is a QDataStream: the client sends the mode flags (the same of
+// main(): -l, -i, -c, -r, --empty and --all-screens, or nothing to grab the
+// desktop) as a list of strings, and the daemon replies with an error message
+// (empty on success)
+class ZoomDaemon : public QObject
+{
+  Q_OBJECT
+
+  public:
+    ZoomDaemon(const DaemonConfig config);
+    ~ZoomDaemon();
+
+    // Returns false if the socket couldn't be created
+    bool listen();
+
+  private:
+    DaemonConfig _config;
+    QLocalServer _server;
+    ZoomWidget *_widget; // Hidden until it's triggered
+
+    void prepareWidget();
+    void acceptConnection();
+    void readRequest(QLocalSocket *socket);
+    // Returns the error message (empty if it was shown)
+    QString activate(const QList<QString> args);
+    void finishSession();
+};
+
+// Full name of the socket, for the user running the app
+QString daemonSocketName();
+
+// Client of the daemon (--trigger). Returns the exit status of the program
+int triggerDaemon(const QList<QString> args);
+
+#endif // DAEMON_HPP
@@ -0,0 +1,222 @@
+#include "exporter.hpp"
+
+#include "pngencoder.hpp"
+#include "renderer.hpp"
+#include "project.hpp"
+#include "qoi.hpp"
+#include "vectorexport.hpp"
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QImageReader>
+#include <stdio.h>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+// Descriptor where the images are written with STDIO_PATH (see
+// reserveStdoutForImage())
+static int stdoutImageFd = 1;
+
+bool isImageFormatSupported(const QString extension)
+{
+  return extension.toLower() == QOI_EXTENSION
+      || isVectorFormat(extension)
+      || QImageWriter::supportedImageFormats().contains(extension.toLatin1());
+}
+
+bool writeImage(const QImage &image, QIODevice *device, const QString format)
+{
+  if (format.toLower() == QOI_EXTENSION) {
+    const QByteArray bytes = encodeQoi(image);
+    return !bytes.isEmpty() && device->write(bytes) == bytes.size();
+  }
+
+  if (format.toLower() == "png") {
+    return writePng(image, device);
+  }
+
+  return image.save(device, format.toLatin1().constData());
+}
+
+bool writeImage(const QImage &image, const QString path)
+{
+  const QString extension = QFileInfo(path).suffix().toLower();
+  if (extension != "png" && extension != QOI_EXTENSION) {
+    return image.save(path);
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  const bool success = writeImage(image, &file, extension);
+  if (!success) {
+    file.remove();
+  }
+  return success;
+}
+
+QString clipboardImageFormat(const QList<QString> &mimeTypes)
+{
+  // From the cheapest to decode to the most expensive
+  static const QList<QString> preferred = {
+    "image/bmp", "image/x-bmp", "image/x-portable-pixmap", "image/x-portable-anymap",
+    "image/tiff", "image/jpeg", "image/webp", "image/png"
+  };
+
+  for (int i=0; i<preferred.size(); i++) {
+    if (mimeTypes.contains(preferred.at(i))) {
+      return preferred.at(i);
+    }
+  }
+
+  // Any other image that Qt can read
+  const QList<QByteArray> supported = QImageReader::supportedMimeTypes();
+  for (int i=0; i<mimeTypes.size(); i++) {
+    if (supported.contains(mimeTypes.at(i).toLatin1())) {
+      return mimeTypes.at(i);
+    }
+  }
+
+  return QString();
+}
+
+void reserveStdoutForImage()
+{
+  // Keep the real standard output for the image, and send everything else
+  // that is printed there to the standard error
+  fflush(stdout);
+#ifdef Q_OS_UNIX
+  const int fd = dup(STDOUT_FILENO);
+  if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+    return;
+  }
+
+  stdoutImageFd = fd;
+#endif
+}
+
+static bool openStdout(QFile *file)
+{
+  return file->open(stdoutImageFd, QIODevice::WriteOnly, QFileDevice::DontCloseHandle);
+}
+
+QImage readImage(const QString path)
+{
+  // The encoded image is piped (for example, 'grim - | zoomme -i -')
+  if (path == STDIO_PATH) {
+    QFile input;
+    if (!input.open(stdin, QIODevice::ReadOnly)) {
+      return QImage();
+    }
+
+    const QByteArray bytes = input.readAll();
+    return (bytes.startsWith(QOI_MAGIC)) ? decodeQoi(bytes) : QImage::fromData(bytes);
+  }
+
+  if (QFileInfo(path).suffix().toLower() != QOI_EXTENSION) {
+    return QImage(path);
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return QImage();
+  }
+
+  return decodeQoi(file.readAll());
+}
+
+// Same scale as QImage::save(): the higher the quality, the less compressed
+static int pngCompressionLevel(const int quality)
+{
+  return (quality < 0) ? PNG_COMPRESSION_LEVEL : (100 - quality) * 9 / 100;
+}
+
+void ImageExporter::saveImage(const QImage image, const QString path)
+{
+  const bool success = writeImage(image, path);
+  emit imageSaved(path, success);
+}
+
+void ImageExporter::encodeImage(const QImage image, const QString format, const int quality)
+{
+  QByteArray bytes;
+  QBuffer buffer(&bytes); buffer.open(QIODevice::WriteOnly);
+
+  bool success;
+  if (format.toLower() == "png") {
+    success = writePng(image, &buffer, pngCompressionLevel(quality));
+  } else {
+    success = image.save(&buffer, format.toUpper().toLatin1().constData(), quality);
+  }
+
+  if (!success) {
+    bytes.clear();
+  }
+
+  emit imageEncoded(bytes, format);
+}
+
+void ImageExporter::saveScaledImage(const Project &project, const QRect area, const int scale, const QString path)
+{
+  if (QFileInfo(path).suffix().toLower() != "png") {
+    saveImage(renderScaledImage(project, area, scale), path);
+    return;
+  }
+
+  QFile file(path);
+  bool success = file.open(QIODevice::WriteOnly)
+              && renderScaledPng(project, area, scale, &file, PNG_COMPRESSION_LEVEL);
+  if (!success) {
+    file.remove();
+  }
+
+  emit imageSaved(path, success);
+}
+
+void ImageExporter::encodeScaledImage(const Project &project, const QRect area, const int scale, const QString format, const int quality)
+{
+  if (format.toLower() != "png") {
+    encodeImage(renderScaledImage(project, area, scale), format, quality);
+    return;
+  }
+
+  QByteArray bytes;
+  QBuffer buffer(&bytes); buffer.open(QIODevice::WriteOnly);
+  if (!renderScaledPng(project, area, scale, &buffer, pngCompressionLevel(quality))) {
+    bytes.clear();
+  }
+
+  emit imageEncoded(bytes, format);
+}
+
+void ImageExporter::saveVectorImage(const Project &project, const QRect area, const QString path)
+{
+  const bool success = writeVectorImage(project, area, path);
+  emit imageSaved(path, success);
+}
+
+void ImageExporter::saveToStdout(const Project &project, const QRect area, const int scale, const QString format)
+{
+  QFile output;
+  bool success = openStdout(&output);
+
+  if (success) {
+    if (format.toLower() == "svg") {
+      success = writeSvg(project, area, &output);
+    } else if (format.toLower() == "pdf") {
+      success = writePdf(project, area, &output);
+    } else if (format.toLower() == "png") {
+      success = renderScaledPng(project, area, scale, &output, PNG_COMPRESSION_LEVEL);
+    } else {
+      success = writeImage(renderScaledImage(project, area, scale), &output, format);
+    }
+
+    success = output.flush() && success;
+  }
+
+  emit imageSaved(STDIO_PATH, success);
+}
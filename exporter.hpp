@@ -0,0 +1,76 @@
+#ifndef EXPORTER_HPP
+#define EXPORTER_HPP
+
+#include <QObject>
+#include <QImage>
+#include <QString>
+#include <QByteArray>
+#include <QRect>
+#include <QIODevice>
+
+// Path of the standard input (-i -) and the standard output (-o -)
+#define STDIO_PATH "-"
+
+// Declared in project.hpp, which can't be included here (it includes
+// zoomwidget.hpp, that includes this file)
+struct Project;
+
+// Returns true if the images can be saved with that extension (the formats of
+// Qt, plus the built-in QOI codec and the vector formats)
+bool isImageFormatSupported(const QString extension);
+// Saves the image in the path (the format is taken from the extension). The
+// PNG images are encoded in parallel with writePng()
+bool writeImage(const QImage &image, const QString path);
+// Same, but the format is given (the extension)
+bool writeImage(const QImage &image, QIODevice *device, const QString format);
+// Same as QImage(path), but it can also read QOI images. Returns a null image
+// if the image couldn't be read. With STDIO_PATH, the encoded image is read
+// from the standard input
+QImage readImage(const QString path);
+
+// Returns the MIME type of the image offered by the clipboard that is the
+// cheapest to decode (the uncompressed formats first), or an empty string if it
+// doesn't offer any image that can be read
+QString clipboardImageFormat(const QList<QString> &mimeTypes);
+
+// The standard output is kept for the exported image (see
+// ImageExporter::saveToStdout()), and the messages that would be printed there
+// are printed in the standard error, so they don't corrupt the image
+void reserveStdoutForImage();
+
+// Encodes and writes the exported images. It lives in its own thread, so that
+// saving a big image doesn't freeze the app. The requests are queued in the
+// event loop of that thread, so several exports in a row are saved one after
+// the other while the user keeps working
+class ImageExporter : public QObject
+{
+  Q_OBJECT
+
+  public:
+    // Same as saveImage() and encodeImage(), but the image is rendered from the
+    // project at 'scale' times its resolution. The PNG images are rendered and
+    // encoded band by band (see renderScaledPng())
+    void saveScaledImage(const Project &project, const QRect area, const int scale, const QString path);
+    void encodeScaledImage(const Project &project, const QRect area, const int scale, const QString format, const int quality);
+    // Saves the area with the drawings as vectors (SVG or PDF, depending on the
+    // extension of the path)
+    void saveVectorImage(const Project &project, const QRect area, const QString path);
+    // Writes the area in the standard output, in the given format (any of the
+    // formats of the images). imageSaved() is emitted with STDIO_PATH
+    void saveToStdout(const Project &project, const QRect area, const int scale, const QString format);
+
+  public slots:
+    void saveImage(const QImage image, const QString path);
+    // The quality is passed to QImage::save() (-1 for the default). For PNG, it's
+    // mapped to the compression level of writePng()
+    void encodeImage(const QImage image, const QString format, const int quality);
+
+  signals:
+    // Emitted from the exporter thread. Connect it with a queued connection to
+    // handle it in the GUI thread
+    void imageSaved(const QString path, const bool success);
+    // The bytes are empty if the image couldn't be encoded
+    void imageEncoded(const QByteArray bytes, const QString format);
+};
+
+#endif // EXPORTER_HPP
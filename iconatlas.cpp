@@ -0,0 +1,140 @@
+#include "iconatlas.hpp"
+
+#include <QFontMetrics>
+#include <cmath>
+
+// Width of the atlas before starting a new row of glyphs (in logical pixels)
+#define ATLAS_WIDTH 512
+// Empty pixels around each glyph, so the smooth scaling doesn't take pixels of
+// the neighbours
+#define ATLAS_PADDING 1
+// Tinted copies of the atlas that are kept (the tool bar only uses a few
+// colors: normal, hovered, active and disabled)
+#define ATLAS_MAX_COLORS 8
+
+IconAtlas::IconAtlas() : _devicePixelRatio(1.0)
+{
+}
+
+void IconAtlas::setFont(const QFont &font)
+{
+  _font = font;
+  rasterize();
+}
+
+void IconAtlas::addIcons(const QList<QString> &icons)
+{
+  bool added = false;
+  for (int i=0; i<icons.size(); i++) {
+    if (!icons.at(i).isEmpty() && !_icons.contains(icons.at(i))) {
+      _icons.append(icons.at(i));
+      added = true;
+    }
+  }
+
+  if (added) {
+    rasterize();
+  }
+}
+
+int IconAtlas::lineHeight() const
+{
+  return QFontMetrics(_font).height();
+}
+
+void IconAtlas::rasterize()
+{
+  const QFontMetrics metrics(_font);
+
+  // Place the glyphs in rows (all the rows have the height of the font)
+  _glyphs.clear();
+  int x = 0, y = 0, rowHeight = 0, width = 0;
+  for (int i=0; i<_icons.size(); i++) {
+    const QString &icon = _icons.at(i);
+    // The glyphs of the icons are usually wider than their advance, so the
+    // bounding rect is used too
+    const QRect bounds = metrics.boundingRect(icon)
+                           .united(QRect(0, -metrics.ascent(), metrics.horizontalAdvance(icon), metrics.height()));
+    const QSize cell = bounds.size() + QSize(ATLAS_PADDING*2, ATLAS_PADDING*2);
+
+    if (x > 0 && x + cell.width() > ATLAS_WIDTH) {
+      x = 0;
+      y += rowHeight;
+      rowHeight = 0;
+    }
+
+    _glyphs.insert(icon, Glyph{
+      QRect(QPoint(x + ATLAS_PADDING, y + ATLAS_PADDING), bounds.size()),
+      bounds.topLeft(),
+      metrics.horizontalAdvance(icon)
+    });
+
+    x += cell.width();
+    rowHeight = qMax(rowHeight, cell.height());
+    width = qMax(width, x);
+  }
+
+  _tinted.clear();
+  if (_glyphs.isEmpty()) {
+    _atlas = QImage();
+    return;
+  }
+
+  _atlas = QImage(std::ceil(width * _devicePixelRatio), std::ceil((y + rowHeight) * _devicePixelRatio),
+                  QImage::Format_ARGB32_Premultiplied);
+  _atlas.setDevicePixelRatio(_devicePixelRatio);
+  _atlas.fill(Qt::transparent);
+
+  QPainter painter(&_atlas);
+  painter.setFont(_font);
+  painter.setPen(Qt::white);
+  for (auto glyph = _glyphs.constBegin(); glyph != _glyphs.constEnd(); glyph++) {
+    painter.drawText(glyph->source.topLeft() - glyph->offset, glyph.key());
+  }
+}
+
+const QPixmap &IconAtlas::tintedAtlas(const QColor color)
+{
+  auto tinted = _tinted.find(color.rgba());
+  if (tinted != _tinted.end()) {
+    return *tinted;
+  }
+
+  if (_tinted.size() >= ATLAS_MAX_COLORS) {
+    _tinted.clear();
+  }
+
+  // Keep the coverage of the glyphs and replace the white with the color
+  QImage image = _atlas;
+  QPainter painter(&image);
+  painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+  painter.fillRect(QRect(QPoint(0, 0), image.deviceIndependentSize().toSize()), color);
+  painter.end();
+
+  return *_tinted.insert(color.rgba(), QPixmap::fromImage(image));
+}
+
+void IconAtlas::drawIcon(QPainter *painter, const QRect line, const QString &icon, const QColor color)
+{
+  if (icon.isEmpty()) {
+    return;
+  }
+
+  // Rasterize it again for the screen where it's drawn (HiDPI)
+  const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
+  if (devicePixelRatio != _devicePixelRatio) {
+    _devicePixelRatio = devicePixelRatio;
+    rasterize();
+  }
+
+  if (!_glyphs.contains(icon)) {
+    addIcons({icon});
+  }
+
+  const Glyph &glyph = _glyphs[icon];
+  const QPoint baseline(line.x() + (line.width() - glyph.advance)/2, line.y() + QFontMetrics(_font).ascent());
+  const QRect target(baseline + glyph.offset, glyph.source.size());
+  const QRectF source(QPointF(glyph.source.topLeft()) * _devicePixelRatio, QSizeF(glyph.source.size()) * _devicePixelRatio);
+
+  painter->drawPixmap(QRectF(target), tintedAtlas(color), source);
+}
@@ -0,0 +1,55 @@
+#ifndef ICONATLAS_HPP
+#define ICONATLAS_HPP
+
+#include <QPainter>
+#include <QImage>
+#include <QPixmap>
+#include <QFont>
+#include <QColor>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QRect>
+
+// Glyphs of the icons rasterized once into a single image (the atlas), so the
+// tool bar draws them as blits instead of shaping the text of the icon font
+// every frame. The glyphs are white (only the alpha is used), and a copy of
+// the atlas is tinted for each color the first time that it's used
+class IconAtlas
+{
+  public:
+    IconAtlas();
+
+    // Font of the icons. The glyphs are rasterized again with the new font
+    void setFont(const QFont &font);
+    // Rasterizes the icons that aren't in the atlas yet (the icons that aren't
+    // added are rasterized the first time that they're drawn)
+    void addIcons(const QList<QString> &icons);
+
+    // Height of a line of the font (in logical pixels)
+    int lineHeight() const;
+
+    // Draws the icon like QPainter::drawText() would draw it as a line of text
+    // centered horizontally in the rect (the top of the line is the top of the
+    // rect)
+    void drawIcon(QPainter *painter, const QRect line, const QString &icon, const QColor color);
+
+  private:
+    struct Glyph {
+      QRect source; // In the atlas (in logical pixels)
+      QPoint offset; // From the start of the baseline to the top-left of the source
+      int advance;
+    };
+
+    QFont _font;
+    qreal _devicePixelRatio;
+    QList<QString> _icons;
+    QHash<QString, Glyph> _glyphs;
+    QImage _atlas;
+    QHash<QRgb, QPixmap> _tinted;
+
+    void rasterize();
+    const QPixmap &tintedAtlas(const QColor color);
+};
+
+#endif // ICONATLAS_HPP
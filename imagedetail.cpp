@@ -0,0 +1,158 @@
+#include "imagedetail.hpp"
+#include "exporter.hpp"
+
+#include <QImageReader>
+#include <QImageIOHandler>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <cmath>
+
+// Key of the tile in the cache
+#define TILE_KEY(column, row) (((quint64)(column) << 32) | (quint32)(row))
+
+QImage readImagePreview(const QString path, const QSize maxSize, QSize *fullSize)
+{
+  *fullSize = QSize();
+
+  // The standard input can't be read twice
+  if (path == STDIO_PATH) {
+    return readImage(path);
+  }
+
+  QImageReader reader(path);
+  const QSize size = reader.size();
+  const bool fits = size.isValid() && size.width() <= maxSize.width() && size.height() <= maxSize.height();
+  if (!size.isValid() || fits || !reader.supportsOption(QImageIOHandler::ClipRect)) {
+    return readImage(path);
+  }
+
+  // The reader of these formats can decode the preview directly at the scaled
+  // size (for example, JPEG only decodes a fraction of the coefficients)
+  reader.setScaledSize(size.scaled(maxSize, Qt::KeepAspectRatio));
+  const QImage preview = reader.read();
+  if (preview.isNull()) {
+    return readImage(path);
+  }
+
+  *fullSize = size;
+  return preview;
+}
+
+ImageDetail::ImageDetail() : QObject()
+{
+  _tiles.setMaxCost(IMAGE_DETAIL_CACHE_SIZE);
+}
+
+ImageDetail::~ImageDetail()
+{
+  for (auto watcher = _decoding.constBegin(); watcher != _decoding.constEnd(); watcher++) {
+    (*watcher)->waitForFinished();
+  }
+}
+
+void ImageDetail::setImage(const QString path, const QSize fullSize, const QSize previewSize)
+{
+  _path = path;
+  _fullSize = fullSize;
+  _previewSize = previewSize;
+  _tiles.clear();
+}
+
+bool ImageDetail::isEnabled() const
+{
+  return _fullSize.isValid() && !_path.isEmpty();
+}
+
+QRect ImageDetail::tileRect(const int column, const int row) const
+{
+  return QRect(column * IMAGE_DETAIL_TILE_SIZE, row * IMAGE_DETAIL_TILE_SIZE,
+               IMAGE_DETAIL_TILE_SIZE, IMAGE_DETAIL_TILE_SIZE).intersected(QRect(QPoint(0, 0), _fullSize));
+}
+
+void ImageDetail::draw(QPainter *painter, const QRectF imageRect, const QRect visibleRect)
+{
+  if (!isEnabled() || imageRect.isEmpty()) {
+    return;
+  }
+
+  // The preview is enough while it's not magnified (in real pixels)
+  const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
+  if (imageRect.width() * devicePixelRatio <= _previewSize.width()) {
+    return;
+  }
+
+  // Visible area in pixels of the full image
+  const qreal scaleX = imageRect.width()  / _fullSize.width();
+  const qreal scaleY = imageRect.height() / _fullSize.height();
+  const QRectF visible = QRectF(visibleRect).intersected(imageRect).translated(-imageRect.topLeft());
+  if (visible.isEmpty()) {
+    return;
+  }
+
+  const int firstColumn = visible.left()   / scaleX / IMAGE_DETAIL_TILE_SIZE;
+  const int lastColumn  = visible.right()  / scaleX / IMAGE_DETAIL_TILE_SIZE;
+  const int firstRow    = visible.top()    / scaleY / IMAGE_DETAIL_TILE_SIZE;
+  const int lastRow     = visible.bottom() / scaleY / IMAGE_DETAIL_TILE_SIZE;
+
+  painter->save();
+  painter->setRenderHint(QPainter::SmoothPixmapTransform);
+  for (int row=firstRow; row<=lastRow; row++) {
+    for (int column=firstColumn; column<=lastColumn; column++) {
+      const QRect rect = tileRect(column, row);
+      if (rect.isEmpty()) {
+        continue;
+      }
+
+      const quint64 key = TILE_KEY(column, row);
+      const QPixmap *tile = _tiles.object(key);
+      if (!tile) {
+        decodeTile(key, rect);
+        continue;
+      }
+
+      const QRectF target(imageRect.x() + rect.x() * scaleX,
+                          imageRect.y() + rect.y() * scaleY,
+                          rect.width()  * scaleX,
+                          rect.height() * scaleY);
+      painter->drawPixmap(target, *tile, QRectF(tile->rect()));
+    }
+  }
+  painter->restore();
+}
+
+void ImageDetail::decodeTile(const quint64 key, const QRect rect)
+{
+  // Already being decoded, or too many regions at the same time (the ones that
+  // are still visible are requested again in the next frame)
+  if (_decoding.contains(key) || _decoding.size() >= QThreadPool::globalInstance()->maxThreadCount()) {
+    return;
+  }
+
+  QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+  _decoding.insert(key, watcher);
+
+  connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, key, watcher]() {
+    const QImage image = watcher->result();
+    _decoding.remove(key);
+    watcher->deleteLater();
+
+    // If the file can't be decoded anymore (for example, it was deleted), keep
+    // showing the preview instead of trying it again every frame
+    if (image.isNull()) {
+      _fullSize = QSize();
+      return;
+    }
+
+    const int cost = qMax<qsizetype>(1, image.sizeInBytes() / 1024);
+    _tiles.insert(key, new QPixmap(QPixmap::fromImage(image)), cost);
+    emit tileDecoded();
+  });
+
+  // Each task has its own reader, because they can't be shared between threads
+  const QString path = _path;
+  watcher->setFuture(QtConcurrent::run([path, rect]() {
+    QImageReader reader(path);
+    reader.setClipRect(rect);
+    return reader.read();
+  }));
+}
@@ -0,0 +1,69 @@
+#ifndef IMAGEDETAIL_HPP
+#define IMAGEDETAIL_HPP
+
+#include <QObject>
+#include <QImage>
+#include <QPixmap>
+#include <QPainter>
+#include <QString>
+#include <QSize>
+#include <QRect>
+#include <QCache>
+#include <QHash>
+#include <QFutureWatcher>
+
+// The huge images (-i) are shown from a preview that fits the screen, and the
+// regions that the user zooms into are decoded at full resolution on demand.
+// It's only used with the formats that can decode a region without decoding
+// the whole image (like JPEG), the others are decoded at once like before
+
+// Size of the preview, times the size of the screen (so zooming a little
+// doesn't need the full resolution yet)
+#define IMAGE_PREVIEW_SCALE 2
+// Side of the regions that are decoded (in pixels of the full image)
+#define IMAGE_DETAIL_TILE_SIZE 1024
+// Maximum size of the decoded regions that are kept in memory
+#define IMAGE_DETAIL_CACHE_SIZE (256*1024) // KB
+
+// Reads the image. If it's bigger than maxSize and its format can decode
+// regions, a preview that fits maxSize is returned and the size of the full
+// image is set in fullSize. Otherwise, the whole image is returned and
+// fullSize is set to an invalid size
+QImage readImagePreview(const QString path, const QSize maxSize, QSize *fullSize);
+
+class ImageDetail : public QObject
+{
+  Q_OBJECT
+
+  public:
+    ImageDetail();
+    // Waits for the regions that are being decoded
+    ~ImageDetail();
+
+    // The preview size is the size of the pixmap that shows the image
+    void setImage(const QString path, const QSize fullSize, const QSize previewSize);
+    bool isEnabled() const;
+
+    // Draws the decoded regions of the image that are visible, if the image is
+    // shown bigger than its preview. imageRect is where the whole image is
+    // drawn (in the coordinates of the painter). The missing regions are
+    // decoded in the thread pool (tileDecoded() is emitted when each one is
+    // ready)
+    void draw(QPainter *painter, const QRectF imageRect, const QRect visibleRect);
+
+  signals:
+    void tileDecoded();
+
+  private:
+    QString _path;
+    QSize _fullSize;
+    QSize _previewSize;
+
+    QCache<quint64, QPixmap> _tiles; // The cost is in KB
+    QHash<quint64, QFutureWatcher<QImage>*> _decoding;
+
+    QRect tileRect(const int column, const int row) const;
+    void decodeTile(const quint64 key, const QRect rect);
+};
+
+#endif // IMAGEDETAIL_HPP
@@ -1,4 +1,11 @@
 #include "zoomwidget.hpp"
+#include "renderer.hpp"
+#include "pngencoder.hpp"
+#include "exporter.hpp"
+#include "startupprofile.hpp"
+#include "daemon.hpp"
+#include "selftest.hpp"
+#include <QCoreApplication>
 #include <QtWidgets/QApplication>
 #include <QCursor>
 #include <QScreen>
@@ -9,6 +16,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <QFileInfo>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
 
 void help(const char *errorMsg)
 {
@@ -33,19 +42,31 @@ void help(const char *errorMsg)
   fprintf(output, "\nConfigurations:\n");
   fprintf(output, "  -p [path/to/folder]       Set the path where to save the exported files (default: Desktop folder)\n");
   fprintf(output, "  -n [file_name]            Specify the name of the exported files (default: Zoomme {date})\n");
-  fprintf(output, "  -e:i [extension]          Specify the extension of the exported (saved) image (default: png)\n");
+  fprintf(output, "  -e:i [extension]          Specify the extension of the exported (saved) image (default: png). 'qoi' is much faster to save\n");
   fprintf(output, "  -e:v [extension]          Specify the extension of the exported (saved) video file (default: mp4)\n");
+  fprintf(output, "  -e:c [png|bmp]            Specify the format of the images copied to the clipboard (default: png). BMP is faster, but bigger\n");
+  fprintf(output, "  -s [scale]                Resolution of the exported images, times the resolution of the screen. The drawings are rendered again (default: 1)\n");
+  fprintf(output, "  -o [path]                 Output of --render (the image path, or a folder when rendering multiple files) or --thumbnail (default: next to each file)\n");
+  fprintf(output, "  -o -                      Write the exported image in the standard output (in the format of -e:i) and exit, instead of saving it in a file\n");
 
   fprintf(output, "\nModes:\n");
-  fprintf(output, "  -l                        Not use a background (transparent). In this mode zooming is disabled\n");
-  fprintf(output, "  -i <image_path> [opts]    Specify the path to an image as the background, instead of the desktop.\n");
+  fprintf(output, "  -l                        Not use a background (transparent). When zooming, the desktop under the magnified area is captured periodically\n");
+  fprintf(output, "  -i <image_path> [opts]    Specify the path to an image as the background, instead of the desktop ('-' reads it from the standard input).\n");
   fprintf(output, "       --copy                    This will copy the source image path (autocompletes -p, -e and -n flags) -it will NOT replace the original image-.\n");
   fprintf(output, "  -r [path/to/file]         Load/Restore the state of the program saved in that file. It should be a '.zoomme' file\n");
   fprintf(output, "  -c                        Load an image from the clipboard as the background, instead of the desktop.\n");
+  fprintf(output, "  --all-screens             Grab all the screens (not only the one under the cursor). Zoom in and move the mouse to go to the other screens\n");
   fprintf(output, "  --empty [width] [height]  Create an empty blackboard with the given size\n");
+  fprintf(output, "  --render <files.zoomme>   Render the given '.zoomme' files to images (in parallel) without opening a window\n");
+  fprintf(output, "  --daemon                  Keep ZoomMe running in the background (hidden), ready to be shown with --trigger\n");
+  fprintf(output, "  --trigger [mode]          Show the ZoomMe of the daemon. The mode can be: -l, -i <image_path>, -c, -r <file>, --empty <width> <height>, --all-screens (default: desktop)\n");
+  fprintf(output, "  --thumbnail <file>        Extract the thumbnail embedded in a '.zoomme' file without opening a window\n");
 
   fprintf(output, "\nExperimental:\n");
   fprintf(output, "  --floating                This option bypasses the window manager hint and creates its own window\n");
+  fprintf(output, "  --startup-profile         Print how long each phase of the startup takes (and the time until the first frame)\n");
+  fprintf(output, "  --benchmark <image_path>  Compare the parallel PNG encoder with the one of Qt, using the given image\n");
+  fprintf(output, "  --self-test               Check the encoders, the project files and the hit tests (no window)\n");
 
   fprintf(output, "\n  For more information, visit https://github.com/Ezee1015/zoomme\n");
 
@@ -66,11 +87,17 @@ QString nextToken(const int argc, char *argv[], int *pos, const QString type)
 
 enum Mode {
   DESKTOP,    // Grab the desktop (default)
+  ALL_SCREENS, // Grab all the screens
   LIVE_MODE,
   IMAGE,      // Grab an image
   CLIPBOARD,  // Grab an image from the clipboard
   BACKUP,     // Recover from a backup file (.zoomme)
-  BLACKBOARD  // Empty pixmap
+  BLACKBOARD, // Empty pixmap
+  RENDER,     // Render .zoomme files to images (no window)
+  THUMBNAIL,  // Extract the thumbnail of a .zoomme file (no window)
+  BENCHMARK,  // Benchmark the PNG encoder (no window)
+  SELF_TEST,  // Check the encoders and the algorithms (no window)
+  DAEMON      // Wait in the background for --trigger
 };
 
 void setMode(Mode *mode, const Mode newMode)
@@ -96,6 +123,30 @@ void setMode(Mode *mode, const Mode newMode)
       help("Mode already provided (empty blackboard)");
       break;
 
+    case RENDER:
+      help("Mode already provided (render files)");
+      break;
+
+    case THUMBNAIL:
+      help("Mode already provided (extract thumbnail)");
+      break;
+
+    case BENCHMARK:
+      help("Mode already provided (benchmark)");
+      break;
+
+    case SELF_TEST:
+      help("Mode already provided (self-test)");
+      break;
+
+    case DAEMON:
+      help("Mode already provided (daemon)");
+      break;
+
+    case ALL_SCREENS:
+      help("Mode already provided (all the screens)");
+      break;
+
     case DESKTOP: // Default value
       *mode = newMode;
       break;
@@ -104,16 +155,56 @@ void setMode(Mode *mode, const Mode newMode)
 
 int main(int argc, char *argv[])
 {
+  // The client of the daemon only sends the mode, so it doesn't need a GUI (and
+  // it shouldn't pay for creating one)
+  if (argc > 1 && strcmp(argv[1], "--trigger") == 0) {
+    QCoreApplication client(argc, argv);
+
+    QList<QString> args;
+    for (int i=2; i<argc; ++i) args.append(argv[i]);
+
+    // The daemon runs in another working directory, so the paths are sent
+    // absolute
+    const bool hasPath = args.size() == 2 && (args.first() == "-i" || args.first() == "-r") && args.at(1) != STDIO_PATH;
+    if (hasPath) {
+      args[1] = QFileInfo(args.at(1)).absoluteFilePath();
+    }
+
+    return triggerDaemon(args);
+  }
+
+  // The headless modes don't need a display, so they run on the offscreen
+  // platform (it has to be set before creating the application)
+  for (int i=1; i<argc; ++i) {
+    if (strcmp(argv[i], "--startup-profile") == 0) {
+      enableStartupProfile();
+    }
+
+    // The image is written in the standard output, so nothing else can be
+    // printed there (not even the messages of Qt)
+    if (strcmp(argv[i], "-o") == 0 && i+1 < argc && strcmp(argv[i+1], STDIO_PATH) == 0) {
+      reserveStdoutForImage();
+    }
+
+    const bool headless = (strcmp(argv[i], "--render") == 0 || strcmp(argv[i], "--thumbnail") == 0 ||
+                           strcmp(argv[i], "--benchmark") == 0 || strcmp(argv[i], "--self-test") == 0);
+    if (headless && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+  }
+
+  qint64 phaseStart = profileNow();
   QApplication a(argc, argv);
-  QSystemTrayIcon tray = QSystemTrayIcon(QIcon(":/resources/icon/Icon.png"));
-  tray.setVisible(true);
-  tray.show();
+  profilePhase("QApplication", phaseStart);
 
   // Configurations
   QString savePath;
   QString saveName;
   QString saveImgExt; // Extension
   QString saveVidExt; // Extension
+  QString saveClipExt; // Extension
+  QString outputPath;
+  int exportScale = 0;
   bool floating = false;
 
   // Modes
@@ -121,12 +212,16 @@ int main(int argc, char *argv[])
   QString imgPath;
   QString backupPath;
   QSize blackboardSize;
+  QList<QString> renderPaths;
 
   // Parsing arguments
   for (int i=1; i<argc ; ++i) {
     if (strcmp(argv[i], "--help") == 0) {
       help("");
 
+    } else if (strcmp(argv[i], "--startup-profile") == 0) {
+      // Already enabled (before creating the application)
+
     } else if (strcmp(argv[i], "--floating") == 0) {
       if (floating) {
         help("Floating option already set");
@@ -144,6 +239,9 @@ int main(int argc, char *argv[])
       if (imgPath == "") {
         help("Copy the image path was indicated, but the source image is not provided");
       }
+      if (imgPath == STDIO_PATH) {
+        help("The image is read from the standard input, so there's no path to copy");
+      }
       if (savePath != "")   help("Saving path already provided");
       if (saveName != "")   help("Saving name already provided");
       if (saveImgExt != "") help("Saving extension already provided");
@@ -181,6 +279,30 @@ int main(int argc, char *argv[])
 
       saveVidExt = nextToken(argc, argv, &i, "Video extension");
 
+    } else if (strcmp(argv[i], "-e:c") == 0) {
+      if (saveClipExt != "") {
+        help("Clipboard image format already provided");
+      }
+
+      saveClipExt = nextToken(argc, argv, &i, "Clipboard image format");
+
+    } else if (strcmp(argv[i], "-s") == 0) {
+      if (exportScale != 0) {
+        help("Export scale already provided");
+      }
+
+      bool scaleCorrect = false;
+      exportScale = nextToken(argc, argv, &i, "Export scale").toInt(&scaleCorrect);
+      if (!scaleCorrect)   help("The given scale is not a number");
+      if (exportScale < 1) help("The given scale is not a positive number");
+
+    } else if (strcmp(argv[i], "-o") == 0) {
+      if (outputPath != "") {
+        help("Output path already provided");
+      }
+
+      outputPath = nextToken(argc, argv, &i, "Output path");
+
     } else if (strcmp(argv[i], "-r") == 0) {
       setMode(&mode, BACKUP);
 
@@ -193,6 +315,9 @@ int main(int argc, char *argv[])
     } else if (strcmp(argv[i], "-c") == 0) {
       setMode(&mode, CLIPBOARD);
 
+    } else if (strcmp(argv[i], "--all-screens") == 0) {
+      setMode(&mode, ALL_SCREENS);
+
     } else if (strcmp(argv[i], "--empty") == 0) {
       setMode(&mode, BLACKBOARD);
 
@@ -205,6 +330,43 @@ int main(int argc, char *argv[])
 
       if (blackboardSize.width() < 1)  help("The given width is not a positive number");
       if (blackboardSize.height() < 1) help("The given height is not a positive number");
+
+    } else if (strcmp(argv[i], "--render") == 0) {
+      setMode(&mode, RENDER);
+
+      // Take all the files until the next flag
+      while (i+1 < argc && argv[i+1][0] != '-') {
+        const QString path = nextToken(argc, argv, &i, "File to render");
+        if (QFileInfo(path).suffix() != "zoomme") {
+          QString errorMsg("It's not a '.zoomme' file: " + path);
+          help(QSTRING_TO_STRING(errorMsg));
+        }
+        renderPaths.append(path);
+      }
+
+      if (renderPaths.isEmpty()) help("Files to render not provided");
+
+    } else if (strcmp(argv[i], "--thumbnail") == 0) {
+      setMode(&mode, THUMBNAIL);
+
+      backupPath = nextToken(argc, argv, &i, "File to extract the thumbnail from");
+      if (QFileInfo(backupPath).suffix() != "zoomme") {
+        QString errorMsg("It's not a '.zoomme' file: " + backupPath);
+        help(QSTRING_TO_STRING(errorMsg));
+      }
+
+    } else if (strcmp(argv[i], "--trigger") == 0) {
+      help("--trigger should be the first argument (followed by the mode)");
+
+    } else if (strcmp(argv[i], "--daemon") == 0) {
+      setMode(&mode, DAEMON);
+
+    } else if (strcmp(argv[i], "--benchmark") == 0) {
+      setMode(&mode, BENCHMARK);
+      imgPath = nextToken(argc, argv, &i, "Image path");
+
+    } else if (strcmp(argv[i], "--self-test") == 0) {
+      setMode(&mode, SELF_TEST);
     }
 
     else {
@@ -214,6 +376,61 @@ int main(int argc, char *argv[])
     }
   }
 
+  const bool outputToStdout = (outputPath == STDIO_PATH && mode != RENDER && mode != THUMBNAIL);
+  if (outputToStdout && (mode == DAEMON || mode == BENCHMARK || mode == SELF_TEST)) {
+    help("The standard output (-o -) can't be used with --daemon, --benchmark or --self-test");
+  }
+  if (outputPath != "" && !outputToStdout && mode != RENDER && mode != THUMBNAIL) {
+    help("The output path is only used when rendering files (--render) or extracting thumbnails (--thumbnail), or it's '-' (the standard output)");
+  }
+
+  if (mode == RENDER) {
+    return renderProjectFiles(renderPaths, outputPath, saveImgExt);
+  }
+  if (mode == THUMBNAIL) {
+    return extractProjectThumbnail(backupPath, outputPath);
+  }
+  if (mode == BENCHMARK) {
+    return benchmarkPngEncoder(imgPath);
+  }
+  if (mode == SELF_TEST) {
+    return runSelfTests();
+  }
+  if (mode == DAEMON) {
+    // The widgets are hidden between the triggers
+    a.setQuitOnLastWindowClosed(false);
+
+    ZoomDaemon daemon(DaemonConfig{
+        .savePath    = savePath,
+        .saveName    = saveName,
+        .imgExt      = saveImgExt,
+        .vidExt      = saveVidExt,
+        .clipExt     = saveClipExt,
+        .exportScale = (exportScale == 0) ? 1 : exportScale,
+        .floating    = floating
+      });
+    if (!daemon.listen()) {
+      return EXIT_FAILURE;
+    }
+    return a.exec();
+  }
+
+  // The image is decoded by the thread pool while the widget is created. If
+  // it's huge, only a preview is decoded (the regions are decoded when zooming)
+  QFuture<QImage> decodedImage;
+  QSize fullImageSize;
+  if (mode == IMAGE) {
+    const QScreen *screen = QApplication::screenAt(QCursor::pos());
+    const QSize previewSize = screen->geometry().size() * screen->devicePixelRatio() * IMAGE_PREVIEW_SCALE;
+    decodedImage = QtConcurrent::run([imgPath, previewSize, &fullImageSize]() {
+      const qint64 start = profileNow();
+      const QImage image = readImagePreview(imgPath, previewSize, &fullImageSize);
+      profilePhase("Image decode", start);
+      return image;
+    });
+  }
+
+  phaseStart = profileNow();
   ZoomWidget w;
   if (floating) {
     w.setWindowFlags(Qt::WindowMinimizeButtonHint | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint | Qt::BypassWindowManagerHint);
@@ -224,23 +441,47 @@ int main(int argc, char *argv[])
   w.resize(QApplication::screenAt(QCursor::pos())->geometry().size());
   w.move(QApplication::screenAt(QCursor::pos())->geometry().topLeft());
   w.setCursor(QCursor(Qt::CrossCursor));
+  QObject::connect(&w, &ZoomWidget::quitRequested, &a, &QApplication::quit);
+  profilePhase("Widget creation", phaseStart);
+
+  // The tray icon is not needed to start zooming, so it's created after the
+  // window is shown
+  QSystemTrayIcon tray;
+  QObject::connect(&w, &ZoomWidget::firstFramePainted, &tray, [&tray]() {
+    const qint64 start = profileNow();
+    tray.setIcon(QIcon(":/resources/icon/Icon.png"));
+    tray.setVisible(true);
+    tray.show();
+    profilePhase("Tray icon", start);
+  });
 
   // Set the path, name and extension for saving the file
-  w.initFileConfig(savePath, saveName, saveImgExt, saveVidExt);
+  w.initFileConfig(savePath, saveName, saveImgExt, saveVidExt, saveClipExt, (exportScale == 0) ? 1 : exportScale);
+  if (outputToStdout) {
+    w.setOutputToStdout();
+  }
 
   // Configure the app mode
+  phaseStart = profileNow();
+  QString grabError;
   switch (mode) {
     case BACKUP:
-      w.restoreStateFromFile(backupPath);
+      if (!w.restoreStateFromFile(backupPath)) {
+        fprintf(stderr, "[ERROR] Couldn't restore the state from the file: %s\n", QSTRING_TO_STRING(backupPath));
+        return EXIT_FAILURE;
+      }
       break;
     case IMAGE:
-      w.grabImage(QPixmap(imgPath));
+      w.grabImage(QPixmap::fromImage(decodedImage.result()));
+      if (fullImageSize.isValid()) {
+        w.setImageDetail(imgPath, fullImageSize);
+      }
       break;
     case BLACKBOARD:
       w.createBlackboard(blackboardSize);
       break;
     case CLIPBOARD:
-      w.grabFromClipboard();
+      grabError = w.grabFromClipboard();
       break;
     case LIVE_MODE:
       // Set transparency for the window
@@ -248,8 +489,23 @@ int main(int argc, char *argv[])
       w.setLiveMode();
       break;
     case DESKTOP:
-      w.grabDesktop();
+      grabError = w.grabDesktop();
       break;
+    case ALL_SCREENS:
+      grabError = w.grabAllScreens();
+      break;
+    case RENDER:
+    case THUMBNAIL:
+    case BENCHMARK:
+    case DAEMON:
+      // Already done (they don't open a window)
+      break;
+  }
+  profilePhase("Grab the background", phaseStart);
+
+  if (!grabError.isEmpty()) {
+    fprintf(stderr, "[ERROR] %s\n", QSTRING_TO_STRING(grabError));
+    return EXIT_FAILURE;
   }
 
   QApplication::beep();
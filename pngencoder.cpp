@@ -0,0 +1,331 @@
+#include "pngencoder.hpp"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QBuffer>
+#include <QList>
+#include <QtEndian>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+// Size of the deflate window, which is also the size of the dictionary shared
+// between the strips
+#define DEFLATE_WINDOW_SIZE 32768
+// The strips smaller than this (in bytes of raw pixels) aren't worth it: the
+// dictionary and the flush of each strip make the file a little bigger
+#define MIN_STRIP_SIZE (256 * 1024)
+
+struct PngStrip {
+  const QImage *image;    // RGB888 or RGBA8888
+  const uchar *firstPrev; // Row above the first one (for the filters)
+  int firstRow;
+  int rowCount;
+  int compressionLevel;
+
+  QByteArray filtered;   // Each row starts with its filter type
+  QByteArray dictionary; // The data that precedes the strip (up to 32KB)
+  QByteArray compressed; // Raw deflate (without the zlib header)
+  uLong adler;           // Adler-32 of the filtered data
+  bool success;
+};
+
+static uchar paethPredictor(const int a, const int b, const int c)
+{
+  const int p  = a + b - c;
+  const int pa = abs(p - a);
+  const int pb = abs(p - b);
+  const int pc = abs(p - c);
+
+  if (pa <= pb && pa <= pc) return a;
+  if (pb <= pc) return b;
+  return c;
+}
+
+// Filters the row with the 5 filters of the PNG spec and keeps the one with the
+// minimum sum of absolute differences (the heuristic suggested by the spec and
+// used by libpng). The candidates buffer must have 5 * length bytes
+static void filterRow(const uchar *row, const uchar *prev, const int length, const int bpp, uchar *candidates, uchar *out)
+{
+  quint64 bestSum = ~(quint64)0;
+  int bestFilter = 0;
+
+  for (int filter=0; filter<5; filter++) {
+    uchar *dst = candidates + filter * length;
+    quint64 sum = 0;
+
+    for (int i=0; i<length; i++) {
+      const int left   = (i >= bpp) ? row[i - bpp] : 0;
+      const int up     = prev[i];
+      const int upLeft = (i >= bpp) ? prev[i - bpp] : 0;
+
+      uchar value = row[i];
+      switch (filter) {
+        case 1: value -= left;                                 break; // Sub
+        case 2: value -= up;                                   break; // Up
+        case 3: value -= (left + up) / 2;                      break; // Average
+        case 4: value -= paethPredictor(left, up, upLeft);     break; // Paeth
+      }
+
+      dst[i] = value;
+      sum += (value < 128) ? value : 256 - value;
+    }
+
+    if (sum < bestSum) {
+      bestSum = sum;
+      bestFilter = filter;
+    }
+  }
+
+  out[0] = bestFilter;
+  memcpy(out + 1, candidates + bestFilter * length, length);
+}
+
+static void filterStrip(PngStrip &strip)
+{
+  const int bpp = (strip.image->format() == QImage::Format_RGBA8888) ? 4 : 3;
+  const int length = strip.image->width() * bpp;
+
+  QByteArray candidates(5 * length, 0);
+  strip.filtered.resize((qsizetype)(length + 1) * strip.rowCount);
+
+  for (int i=0; i<strip.rowCount; i++) {
+    const int y = strip.firstRow + i;
+    const uchar *prev = (i > 0) ? strip.image->constScanLine(y - 1) : strip.firstPrev;
+
+    filterRow(strip.image->constScanLine(y),
+              prev,
+              length,
+              bpp,
+              (uchar *)candidates.data(),
+              (uchar *)strip.filtered.data() + (qsizetype)(length + 1) * i);
+  }
+
+  strip.adler = adler32_z(adler32(0, Z_NULL, 0), (const Bytef *)strip.filtered.constData(), strip.filtered.size());
+}
+
+static void compressStrip(PngStrip &strip)
+{
+  strip.success = false;
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // Negative window bits: raw deflate, the zlib header is written only once
+  if (deflateInit2(&stream, strip.compressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return;
+  }
+
+  if (!strip.dictionary.isEmpty()) {
+    deflateSetDictionary(&stream, (const Bytef *)strip.dictionary.constData(), strip.dictionary.size());
+  }
+
+  // The bound doesn't count the marker of the sync flush
+  strip.compressed.resize(deflateBound(&stream, strip.filtered.size()) + 16);
+  stream.next_in   = (Bytef *)strip.filtered.data();
+  stream.avail_in  = strip.filtered.size();
+  stream.next_out  = (Bytef *)strip.compressed.data();
+  stream.avail_out = strip.compressed.size();
+
+  // Flushed to a byte boundary (without marking the block as the final one),
+  // so the strips can be concatenated. The stream is ended by finish()
+  const int status = deflate(&stream, Z_SYNC_FLUSH);
+  strip.success = (status == Z_OK && stream.avail_in == 0 && stream.avail_out > 0);
+
+  strip.compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  // Not needed anymore (the dictionary of the next strip was already copied)
+  strip.filtered.clear();
+  strip.dictionary.clear();
+}
+
+static bool writeChunk(QIODevice *device, const char *type, const QByteArray &data)
+{
+  uchar length[4], crc[4];
+  qToBigEndian<quint32>(data.size(), length);
+
+  uLong checksum = crc32(0, (const Bytef *)type, 4);
+  checksum = crc32_z(checksum, (const Bytef *)data.constData(), data.size());
+  qToBigEndian<quint32>(checksum, crc);
+
+  return device->write((const char *)length, 4) == 4
+      && device->write(type, 4) == 4
+      && device->write(data) == data.size()
+      && device->write((const char *)crc, 4) == 4;
+}
+
+PngWriter::PngWriter(QIODevice *device, const QSize size, const bool alpha, const int compressionLevel)
+  : _device(device),
+    _size(size),
+    _alpha(alpha),
+    _compressionLevel(compressionLevel),
+    _writtenRows(0),
+    _error(size.isEmpty()),
+    _adler(adler32(0, Z_NULL, 0))
+{
+}
+
+bool PngWriter::writeHeader()
+{
+  QByteArray header(13, 0);
+  qToBigEndian<quint32>(_size.width(), header.data());
+  qToBigEndian<quint32>(_size.height(), header.data() + 4);
+  header[8]  = 8;                 // Bit depth
+  header[9]  = (_alpha) ? 6 : 2;  // Color type (RGBA or RGB)
+  header[10] = 0;                 // Compression (deflate)
+  header[11] = 0;                 // Filter method (adaptive)
+  header[12] = 0;                 // No interlace
+
+  // Start of the zlib stream (it continues in the IDAT chunks of each strip)
+  const QByteArray zlibHeader("\x78\x9C", 2); // 32KB window, default level
+
+  return _device->write("\x89PNG\r\n\x1A\n", 8) == 8
+      && writeChunk(_device, "IHDR", header)
+      && writeChunk(_device, "IDAT", zlibHeader);
+}
+
+bool PngWriter::writeRows(const QImage &band)
+{
+  if (_error || band.isNull()) {
+    return false;
+  }
+
+  if (band.width() != _size.width() || _writtenRows + band.height() > _size.height()) {
+    _error = true;
+    return false;
+  }
+
+  if (_writtenRows == 0 && !writeHeader()) {
+    _error = true;
+    return false;
+  }
+
+  // The PNG stores the colors without premultiplying them
+  const QImage source = band.convertToFormat(_alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+  const qsizetype rowSize = (qsizetype)source.width() * (_alpha ? 4 : 3) + 1;
+  if (_previousRow.isEmpty()) {
+    _previousRow = QByteArray(rowSize - 1, 0); // The first row has no row above
+  }
+
+  // Split the band in strips (a few per thread, so that they're balanced)
+  const int threads = QThreadPool::globalInstance()->maxThreadCount();
+  const qsizetype maxStrips = qMax<qsizetype>(1, (rowSize * source.height()) / MIN_STRIP_SIZE);
+  const int stripCount = (int)qMin<qsizetype>(qMin<qsizetype>(maxStrips, threads * 2), source.height());
+  const int rowsPerStrip = (source.height() + stripCount - 1) / stripCount;
+
+  QList<PngStrip> strips;
+  for (int row=0; row<source.height(); row+=rowsPerStrip) {
+    strips.append(PngStrip{
+        .image            = &source,
+        .firstPrev        = (row > 0) ? source.constScanLine(row - 1) : (const uchar *)_previousRow.constData(),
+        .firstRow         = row,
+        .rowCount         = qMin(rowsPerStrip, source.height() - row),
+        .compressionLevel = _compressionLevel,
+        .filtered         = QByteArray(),
+        .dictionary       = QByteArray(),
+        .compressed       = QByteArray(),
+        .adler            = 0,
+        .success          = false
+      });
+  }
+
+  QtConcurrent::blockingMap(strips, filterStrip);
+
+  // Each strip is primed with the data that precedes it (from this band or from
+  // the previous ones)
+  for (int i=0; i<strips.size(); i++) {
+    strips[i].dictionary = _dictionary;
+
+    const QByteArray &filtered = strips.at(i).filtered;
+    _dictionary = (filtered.size() >= DEFLATE_WINDOW_SIZE) ? filtered.right(DEFLATE_WINDOW_SIZE)
+                                                          : (_dictionary + filtered).right(DEFLATE_WINDOW_SIZE);
+  }
+  _previousRow = QByteArray((const char *)source.constScanLine(source.height() - 1), rowSize - 1);
+
+  QtConcurrent::blockingMap(strips, compressStrip);
+
+  for (int i=0; i<strips.size(); i++) {
+    if (!strips.at(i).success || !writeChunk(_device, "IDAT", strips.at(i).compressed)) {
+      _error = true;
+      return false;
+    }
+    _adler = adler32_combine(_adler, strips.at(i).adler, (rowSize * strips.at(i).rowCount));
+  }
+
+  _writtenRows += source.height();
+  return true;
+}
+
+bool PngWriter::finish()
+{
+  if (_error || _writtenRows != _size.height()) {
+    return false;
+  }
+
+  // An empty final block (with fixed codes) ends the deflate stream, and then
+  // the checksum of the zlib stream
+  QByteArray zlibTrailer("\x03\x00", 2);
+  zlibTrailer.resize(6);
+  qToBigEndian<quint32>(_adler, zlibTrailer.data() + 2);
+
+  return writeChunk(_device, "IDAT", zlibTrailer)
+      && writeChunk(_device, "IEND", QByteArray());
+}
+
+bool writePng(const QImage &image, QIODevice *device, const int compressionLevel)
+{
+  if (image.isNull()) {
+    return false;
+  }
+
+  PngWriter writer(device, image.size(), image.hasAlphaChannel(), compressionLevel);
+  return writer.writeRows(image) && writer.finish();
+}
+
+int benchmarkPngEncoder(const QString imagePath)
+{
+  const QImage image(imagePath);
+  if (image.isNull()) {
+    fprintf(stderr, "[ERROR] Couldn't open the image: %s\n", QSTRING_TO_STRING(imagePath));
+    return EXIT_FAILURE;
+  }
+
+  QElapsedTimer timer;
+
+  QByteArray qtBytes;
+  QBuffer qtBuffer(&qtBytes); qtBuffer.open(QIODevice::WriteOnly);
+  timer.start();
+  const bool qtSuccess = image.save(&qtBuffer, "PNG");
+  const qint64 qtElapsed = timer.elapsed();
+
+  QByteArray parallelBytes;
+  QBuffer parallelBuffer(&parallelBytes); parallelBuffer.open(QIODevice::WriteOnly);
+  timer.start();
+  const bool parallelSuccess = writePng(image, &parallelBuffer);
+  const qint64 parallelElapsed = timer.elapsed();
+
+  if (!qtSuccess || !parallelSuccess) {
+    fprintf(stderr, "[ERROR] Couldn't encode the image\n");
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stdout, "[INFO] Image: %dx%d pixels\n", image.width(), image.height());
+  fprintf(stdout, "[INFO] QImage::save():  %6lld ms  %10lld bytes\n", (long long)qtElapsed, (long long)qtBytes.size());
+  fprintf(stdout, "[INFO] Parallel (%2d threads): %6lld ms  %10lld bytes\n",
+          QThreadPool::globalInstance()->maxThreadCount(),
+          (long long)parallelElapsed,
+          (long long)parallelBytes.size());
+  fprintf(stdout, "[INFO] Speedup: %.2fx\n", (parallelElapsed > 0) ? ((double)qtElapsed / parallelElapsed) : 0.0);
+
+  // Make sure that the parallel encoder is lossless
+  const QImage::Format format = (image.hasAlphaChannel()) ? QImage::Format_RGBA8888 : QImage::Format_RGB888;
+  const QImage decoded = QImage::fromData(parallelBytes, "PNG").convertToFormat(format);
+  if (decoded != image.convertToFormat(format)) {
+    fprintf(stderr, "[ERROR] The image encoded in parallel is different from the original\n");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+#ifndef PNGENCODER_HPP
+#define PNGENCODER_HPP
+
+#include "zoomwidget.hpp"
+#include <QImage>
+#include <QIODevice>
+#include <QString>
+#include <QSize>
+#include <QByteArray>
+#include <zlib.h>
+
+// PNG encoder that uses all the cores. The image is split into horizontal
+// strips, which are filtered and deflated in parallel. Each strip is primed
+// with the last 32KB of the previous one (the deflate window), so the
+// compression is almost the same as compressing it in one piece. The strips are
+// flushed to a byte boundary, so they're stitched together into a single zlib
+// stream (a valid PNG that any decoder can read)
+
+// Writes a PNG band by band (a group of rows), so that images that don't fit in
+// memory can be encoded while they're rendered. Only the current band, the
+// last row and the last 32KB of the filtered data are kept between bands
+class PngWriter
+{
+  public:
+    // The compression level is the one of zlib (0-9)
+    PngWriter(QIODevice *device, const QSize size, const bool alpha, const int compressionLevel = PNG_COMPRESSION_LEVEL);
+
+    // Encodes the next rows of the image. The band must have the width of the
+    // image. Returns false if it couldn't be written
+    bool writeRows(const QImage &band);
+    // Ends the image. Returns false if there was an error or if there are rows
+    // that weren't written
+    bool finish();
+
+  private:
+    QIODevice *_device;
+    QSize _size;
+    bool _alpha;
+    int _compressionLevel;
+
+    int _writtenRows;
+    bool _error;
+    QByteArray _previousRow; // Last row of the previous band (for the filters)
+    QByteArray _dictionary;  // Last 32KB of the filtered data
+    uLong _adler;            // Checksum of all the filtered data
+
+    bool writeHeader();
+};
+
+// Writes the whole image at once. Returns false if the image couldn't be
+// encoded or written in the device
+bool writePng(const QImage &image, QIODevice *device, const int compressionLevel = PNG_COMPRESSION_LEVEL);
+
+// Encodes the image with QImage::save() and with writePng() and prints the
+// time and the size of each one. Returns the exit status of the program
+int benchmarkPngEncoder(const QString imagePath);
+
+#endif // PNGENCODER_HPP
@@ -0,0 +1,182 @@
+#include "project.hpp"
+
+void sendForm(QDataStream *out, const Form &data)
+{
+  *out << data.type
+       << data.points
+       << data.pen
+       << data.highlight
+       << data.arrow
+       << data.deleted
+       << data.penWidths
+       << data.active
+       << data.caretPos
+       << data.text;
+}
+
+Form receiveForm(QDataStream *in)
+{
+  Form data;
+  *in >> data.type
+      >> data.points
+      >> data.pen
+      >> data.highlight
+      >> data.arrow
+      >> data.deleted
+      >> data.penWidths
+      >> data.active
+      >> data.caretPos
+      >> data.text;
+  return data;
+}
+
+void writeProject(QDataStream *out, const Project &project)
+{
+  // Header
+  *out << (quint32)PROJECT_MAGIC
+       << (quint32)PROJECT_VERSION
+       << project.thumbnail;
+
+  // There should be the same arguments that the readProject()
+  *out << project.windowSize
+       << project.source
+       << project.originalSize
+
+       << project.name
+       << project.imageExt
+       << project.videoExt
+       << project.zoommeExt
+       << project.liveMode
+       << project.drawMode
+       << project.activePen
+       << project.highlight
+
+       << project.deletedHistory
+       << (qint64)project.forms.size();
+
+  // Save the drawings
+  for (int i=0; i<project.forms.size(); i++) {
+    sendForm(out, project.forms.at(i));
+  }
+}
+
+// Returns true if the device is at the start of a header (the files saved by
+// older versions start directly with the window size)
+static bool hasProjectHeader(QIODevice *device)
+{
+  QDataStream magicStream(device->peek(sizeof(quint32)));
+  quint32 magic = 0;
+  magicStream >> magic;
+
+  return magicStream.status() == QDataStream::Ok && magic == PROJECT_MAGIC;
+}
+
+// The stream stops at the first error, so its status tells why it stopped
+static ProjectReadStatus streamError(const QDataStream *in, const bool hasHeader)
+{
+  if (!hasHeader) {
+    return PROJECT_READ_INVALID;
+  }
+  return (in->status() == QDataStream::ReadPastEnd) ? PROJECT_READ_TRUNCATED : PROJECT_READ_CORRUPTED;
+}
+
+ProjectReadStatus readProject(QDataStream *in, Project *project)
+{
+  qint64 formListSize = 0;
+
+  project->thumbnail.clear();
+  const bool hasHeader = hasProjectHeader(in->device());
+  if (hasHeader) {
+    quint32 magic, version;
+    *in >> magic
+        >> version;
+
+    if (in->status() != QDataStream::Ok) {
+      return PROJECT_READ_TRUNCATED;
+    }
+    if (version > PROJECT_VERSION) {
+      return PROJECT_READ_NEWER_VERSION;
+    }
+
+    *in >> project->thumbnail;
+  }
+
+  // There should be the same arguments that the writeProject()
+  *in >> project->windowSize
+      >> project->source
+      >> project->originalSize
+
+      >> project->name
+      >> project->imageExt
+      >> project->videoExt
+      >> project->zoommeExt
+      >> project->liveMode
+      >> project->drawMode
+      >> project->activePen
+      >> project->highlight
+
+      >> project->deletedHistory
+      >> formListSize;
+
+  if (in->status() != QDataStream::Ok) {
+    return streamError(in, hasHeader);
+  }
+  if (formListSize < 0) {
+    return (hasHeader) ? PROJECT_READ_CORRUPTED : PROJECT_READ_INVALID;
+  }
+
+  // Read the drawings
+  project->forms.clear();
+  for (qint64 i=0; i<formListSize; i++) project->forms.append(receiveForm(in));
+
+  if (in->status() != QDataStream::Ok) {
+    return streamError(in, hasHeader);
+  }
+  return (in->atEnd()) ? PROJECT_READ_OK : PROJECT_READ_DATA_LEFT;
+}
+
+const char* projectReadError(const ProjectReadStatus status)
+{
+  switch (status) {
+    case PROJECT_READ_OK:            return "";
+    case PROJECT_READ_INVALID:       return "It's not a ZoomMe file (or it's corrupted)";
+    case PROJECT_READ_NEWER_VERSION: return "The file was saved by a newer version of ZoomMe";
+    case PROJECT_READ_TRUNCATED:     return "The file is incomplete (it ends before the project)";
+    case PROJECT_READ_CORRUPTED:     return "The file is corrupted";
+    case PROJECT_READ_DATA_LEFT:     return "There is data left in the file that was not loaded";
+  }
+  return "";
+}
+
+bool isProjectHeaderValid(QIODevice *device)
+{
+  if (!device->isReadable()) {
+    return false;
+  }
+
+  if (!hasProjectHeader(device)) {
+    return true;
+  }
+
+  QDataStream in(device->peek(sizeof(quint32) * 2));
+  quint32 magic, version;
+  in >> magic
+     >> version;
+
+  return in.status() == QDataStream::Ok && version <= PROJECT_VERSION;
+}
+
+bool readProjectThumbnail(QIODevice *device, QByteArray *thumbnail)
+{
+  if (!hasProjectHeader(device)) {
+    return false;
+  }
+
+  quint32 magic, version;
+  QDataStream in(device);
+  in >> magic
+     >> version
+     >> *thumbnail;
+
+  return in.status() == QDataStream::Ok && !thumbnail->isEmpty();
+}
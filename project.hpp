@@ -0,0 +1,69 @@
+#ifndef PROJECT_HPP
+#define PROJECT_HPP
+
+#include "zoomwidget.hpp"
+#include <QDataStream>
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QPen>
+#include <QByteArray>
+#include <QIODevice>
+
+// The '.zoomme' files start with a small header (the magic number, the version
+// and the thumbnail), so that the thumbnail can be read without loading the
+// whole project. The files without it were saved by older versions of ZoomMe
+#define PROJECT_MAGIC   0x5A4F4F4D // "ZOOM"
+#define PROJECT_VERSION 1
+
+// Everything that is stored inside a '.zoomme' file. Remember to update the
+// writeProject() and readProject() functions when modifying this
+struct Project {
+  QByteArray thumbnail; // Encoded image (background + drawings)
+
+  QSize windowSize;
+  QImage source; // Background (desktop, image, blackboard...)
+  QSize originalSize;
+
+  QString name;
+  QString imageExt;
+  QString videoExt;
+  QString zoommeExt;
+  bool liveMode;
+  FormType drawMode;
+  QPen activePen;
+  bool highlight;
+
+  QList<int> deletedHistory;
+  QList<Form> forms;
+};
+
+void sendForm(QDataStream *out, const Form &data);
+Form receiveForm(QDataStream *in);
+
+void writeProject(QDataStream *out, const Project &project);
+// Result of reading a project. Only PROJECT_READ_OK loads it
+enum ProjectReadStatus {
+  PROJECT_READ_OK,
+  PROJECT_READ_INVALID,       // No header, and it can't be read like the files
+                              // of older versions either (not a ZoomMe file)
+  PROJECT_READ_NEWER_VERSION, // Saved by a newer version of ZoomMe
+  PROJECT_READ_TRUNCATED,     // The file ends before the project
+  PROJECT_READ_CORRUPTED,     // The data of the project isn't valid
+  PROJECT_READ_DATA_LEFT,     // There's data left after reading the project
+                              // (the saving and the recovery algorithm are
+                              // out of sync)
+};
+
+ProjectReadStatus readProject(QDataStream *in, Project *project);
+// Message for the errors of readProject()
+const char* projectReadError(const ProjectReadStatus status);
+// Checks only the header of the file, without reading the project. Returns
+// false if it can't be read or if it was saved by a newer version. The files
+// without a header (saved by older versions) are only checked when they're read
+bool isProjectHeaderValid(QIODevice *device);
+// Reads only the header of the file. Returns false if the file doesn't contain
+// a thumbnail (it's not a ZoomMe file or it was saved by an older version)
+bool readProjectThumbnail(QIODevice *device, QByteArray *thumbnail);
+
+#endif // PROJECT_HPP
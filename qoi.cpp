@@ -0,0 +1,224 @@
+#include "qoi.hpp"
+
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00 // 00xxxxxx
+#define QOI_OP_DIFF  0x40 // 01xxxxxx
+#define QOI_OP_LUMA  0x80 // 10xxxxxx
+#define QOI_OP_RUN   0xC0 // 11xxxxxx
+#define QOI_OP_RGB   0xFE // 11111110
+#define QOI_OP_RGBA  0xFF // 11111111
+#define QOI_MASK_2   0xC0 // 11000000
+
+#define QOI_HEADER_SIZE 14
+#define QOI_MAX_RUN     62
+// Limit of the reference implementation (to avoid absurd allocations when
+// decoding a corrupted file)
+#define QOI_PIXELS_MAX  400000000
+
+static const uchar QOI_PADDING[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+struct QoiPixel {
+  uchar r, g, b, a;
+};
+
+static inline bool operator==(const QoiPixel &p1, const QoiPixel &p2)
+{
+  return memcmp(&p1, &p2, sizeof(QoiPixel)) == 0;
+}
+
+static inline int qoiHash(const QoiPixel &px)
+{
+  return (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+}
+
+static inline void writeBigEndian(uchar *bytes, const quint32 value)
+{
+  bytes[0] = value >> 24;
+  bytes[1] = value >> 16;
+  bytes[2] = value >> 8;
+  bytes[3] = value;
+}
+
+static inline quint32 readBigEndian(const uchar *bytes)
+{
+  return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+QByteArray encodeQoi(const QImage &image)
+{
+  if (image.isNull()) {
+    return QByteArray();
+  }
+
+  // Both formats have 4 bytes per pixel in RGBA order (the alpha of RGBX is
+  // always 255), so the pixels can be read the same way
+  const bool alpha = image.hasAlphaChannel();
+  const QImage source = image.convertToFormat(alpha ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888);
+  const int channels = (alpha) ? 4 : 3;
+
+  // Worst case: every pixel is stored with the RGBA op
+  const qsizetype maxSize = QOI_HEADER_SIZE + (qsizetype)source.width() * source.height() * (channels + 1) + sizeof(QOI_PADDING);
+  QByteArray bytes(maxSize, Qt::Uninitialized);
+  uchar *out = (uchar *)bytes.data();
+  qsizetype p = 0;
+
+  // Header
+  memcpy(out, QOI_MAGIC, 4);
+  writeBigEndian(out + 4, source.width());
+  writeBigEndian(out + 8, source.height());
+  out[12] = channels;
+  out[13] = 0; // sRGB with linear alpha
+  p = QOI_HEADER_SIZE;
+
+  QoiPixel index[64];
+  memset(index, 0, sizeof(index));
+  QoiPixel prev = {0, 0, 0, 255};
+  int run = 0;
+
+  for (int y=0; y<source.height(); y++) {
+    const QoiPixel *row = (const QoiPixel *)source.constScanLine(y);
+    const bool lastRow = (y == source.height() - 1);
+
+    for (int x=0; x<source.width(); x++) {
+      const QoiPixel px = row[x];
+
+      if (px == prev) {
+        run++;
+        if (run == QOI_MAX_RUN || (lastRow && x == source.width() - 1)) {
+          out[p++] = QOI_OP_RUN | (run - 1);
+          run = 0;
+        }
+        continue;
+      }
+
+      if (run > 0) {
+        out[p++] = QOI_OP_RUN | (run - 1);
+        run = 0;
+      }
+
+      const int hash = qoiHash(px);
+      if (index[hash] == px) {
+        out[p++] = QOI_OP_INDEX | hash;
+        prev = px;
+        continue;
+      }
+      index[hash] = px;
+
+      if (px.a != prev.a) {
+        out[p++] = QOI_OP_RGBA;
+        out[p++] = px.r;
+        out[p++] = px.g;
+        out[p++] = px.b;
+        out[p++] = px.a;
+        prev = px;
+        continue;
+      }
+
+      const signed char vr = px.r - prev.r;
+      const signed char vg = px.g - prev.g;
+      const signed char vb = px.b - prev.b;
+      const signed char vgr = vr - vg;
+      const signed char vgb = vb - vg;
+
+      if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+        out[p++] = QOI_OP_DIFF | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2);
+      } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8) {
+        out[p++] = QOI_OP_LUMA | (vg + 32);
+        out[p++] = ((vgr + 8) << 4) | (vgb + 8);
+      } else {
+        out[p++] = QOI_OP_RGB;
+        out[p++] = px.r;
+        out[p++] = px.g;
+        out[p++] = px.b;
+      }
+      prev = px;
+    }
+  }
+
+  memcpy(out + p, QOI_PADDING, sizeof(QOI_PADDING));
+  p += sizeof(QOI_PADDING);
+
+  bytes.truncate(p);
+  return bytes;
+}
+
+QImage decodeQoi(const QByteArray &bytes)
+{
+  const uchar *in = (const uchar *)bytes.constData();
+  const qsizetype size = bytes.size();
+
+  if (size < QOI_HEADER_SIZE + (qsizetype)sizeof(QOI_PADDING) || memcmp(in, QOI_MAGIC, 4) != 0) {
+    return QImage();
+  }
+
+  const quint32 width    = readBigEndian(in + 4);
+  const quint32 height   = readBigEndian(in + 8);
+  const int     channels = in[12];
+  if (width == 0 || height == 0 || (channels != 3 && channels != 4) || height >= QOI_PIXELS_MAX / width) {
+    return QImage();
+  }
+
+  QImage image(width, height, (channels == 4) ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888);
+  if (image.isNull()) {
+    return QImage();
+  }
+
+  QoiPixel index[64];
+  memset(index, 0, sizeof(index));
+  QoiPixel px = {0, 0, 0, 255};
+  int run = 0;
+
+  // The ops never read the padding
+  const qsizetype chunksEnd = size - sizeof(QOI_PADDING);
+  qsizetype p = QOI_HEADER_SIZE;
+
+  for (quint32 y=0; y<height; y++) {
+    QoiPixel *row = (QoiPixel *)image.scanLine(y);
+
+    for (quint32 x=0; x<width; x++) {
+      if (run > 0) {
+        run--;
+      } else if (p < chunksEnd) {
+        const int b1 = in[p++];
+
+        if (b1 == QOI_OP_RGB) {
+          if (p + 3 > chunksEnd) return QImage();
+          px.r = in[p++];
+          px.g = in[p++];
+          px.b = in[p++];
+        } else if (b1 == QOI_OP_RGBA) {
+          if (p + 4 > chunksEnd) return QImage();
+          px.r = in[p++];
+          px.g = in[p++];
+          px.b = in[p++];
+          px.a = in[p++];
+        } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+          px = index[b1];
+        } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+          px.r += ((b1 >> 4) & 0x03) - 2;
+          px.g += ((b1 >> 2) & 0x03) - 2;
+          px.b += ( b1       & 0x03) - 2;
+        } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+          if (p + 1 > chunksEnd) return QImage();
+          const int b2 = in[p++];
+          const int vg = (b1 & 0x3F) - 32;
+          px.r += vg - 8 + ((b2 >> 4) & 0x0F);
+          px.g += vg;
+          px.b += vg - 8 +  (b2       & 0x0F);
+        } else if ((b1 & QOI_MASK_2) == QOI_OP_RUN) {
+          run = (b1 & 0x3F);
+        }
+
+        index[qoiHash(px)] = px;
+      } else {
+        // Truncated file
+        return QImage();
+      }
+
+      row[x] = px;
+    }
+  }
+
+  return image;
+}
@@ -0,0 +1,22 @@
+#ifndef QOI_HPP
+#define QOI_HPP
+
+#include <QImage>
+#include <QByteArray>
+
+// Encoder and decoder of the "Quite OK Image" format (https://qoiformat.org).
+// It's lossless like PNG, but it doesn't use deflate (each pixel is stored as
+// a run, a reference to a recently seen color or a small difference with the
+// previous one), so it's an order of magnitude faster to encode and decode. It
+// is used for the quick saves and for the frames of the recordings
+
+#define QOI_EXTENSION "qoi"
+// First bytes of a QOI image
+#define QOI_MAGIC "qoif"
+
+// Returns an empty array if the image is null
+QByteArray encodeQoi(const QImage &image);
+// Returns a null image if the bytes aren't a valid QOI image
+QImage decodeQoi(const QByteArray &bytes);
+
+#endif // QOI_HPP
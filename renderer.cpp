@@ -0,0 +1,830 @@
+#include "renderer.hpp"
+#include "exporter.hpp"
+#include "pngencoder.hpp"
+#include "vectorexport.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <QPainterPath>
+#include <QPair>
+#include <QIODevice>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QBuffer>
+#include <QtConcurrent/QtConcurrentMap>
+
+// Instructions used by isNearPolyline() (SSE2 is always available in x86-64,
+// and NEON in ARM64)
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define HIT_TEST_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #include <arm_neon.h>
+  #define HIT_TEST_NEON 1
+#endif
+
+QRect fixQRect(int x, int y, int width, int height)
+{
+  // The width and height of the rectangle must be positive, otherwise strange
+  // things happen, like only showing the first word on texts, or draw an
+  // ellipse instead of rectangles
+  if (width < 0)  { x+=width;  width=abs(width);   }
+  if (height < 0) { y+=height; height=abs(height); }
+
+  return QRect(x, y, width, height);
+}
+
+void updateFontSize(QPainter *painter)
+{
+  QFont font;
+  font.setPointSize(painter->pen().width() * FONT_SCALE);
+  painter->setFont(font);
+}
+
+void changePenWidth(QPainter *painter, int width)
+{
+  QPen pen = painter->pen();
+  pen.setWidth(width);
+  painter->setPen(pen);
+}
+
+// If the lineLength is 0, it will be calculated with the hypotenuse (the line)
+ArrowHead getArrowHead(const int x, const int y, const int width, const int height, int lineLength)
+{
+  const float opposite=-1 * height;
+  const float adjacent=width;
+  const float hypotenuse=sqrt(pow(opposite,2) + pow(adjacent,2));
+
+  float angle = (adjacent!=0) // Avoid dividing by 0
+                ? atanf(fabs(opposite) / fabs(adjacent))
+                : M_PI/2;
+
+  if (opposite>=0 && adjacent<0) {
+    angle = M_PI-angle;
+  } else if (opposite<0 && adjacent<=0) {
+    angle = M_PI+angle;
+  } else if (opposite<=0 && adjacent>0) {
+    angle = 2*M_PI-angle;
+  }
+
+  // This proportion determines the inclination of the arrowhead's lines.
+  // For example, when the arrow is horizontal, the X and Y lengths of the arrow
+  // should be the same. When it's at a 45º angle, the right-side line of the arrowhead
+  // in X should be 0%, while in Y it should be 100%. When the arrow is at 90º,
+  // the results should be the same as when it was horizontal, and so on...
+
+  // I concluded that the Y-axis should be the opposite of the X-axis on the right-
+  // side line of the arrowhead, and the left-side line of the arrowhead is
+  // the opposite of the right-side line of the arrowhead.
+
+  // I've simplified this behavior with a sinusoidal function, so that:
+  // 0º = 0.5 (min); 45º = 1 (max); 90º = 0.5(min); etc.
+  const float lengthProportion = 0.25 * sin(4*angle-(M_PI/2)) + 0.75;
+
+  // The line's length of the arrow head is a 15% of the main line size
+  if (lineLength == 0) {
+    lineLength = hypotenuse * 0.15;
+    if (lineLength > MAX_ARROWHEAD_LENGTH) lineLength=MAX_ARROWHEAD_LENGTH;
+  }
+
+  // Tip of the line where the arrow head should be drawn
+  int originX=width+x, originY=height+y;
+
+  int rightLineX = lineLength,
+      rightLineY = lineLength,
+      leftLineX  = lineLength,
+      leftLineY  = lineLength;
+
+  // Multiple the size with the direction in the axis
+  rightLineX *= (angle<=(  M_PI/4)) || (angle>(5*M_PI/4)) ? -1 : 1;
+  rightLineY *= (angle<=(3*M_PI/4)) || (angle>(7*M_PI/4)) ? 1 : -1;
+  leftLineX  *= (angle<=(3*M_PI/4)) || (angle>(7*M_PI/4)) ? -1 : 1;
+  leftLineY  *= (angle<=(  M_PI/4)) || (angle>(5*M_PI/4)) ? -1 : 1;
+
+  // Multiply the size with the proportion
+  const bool firstQuadrant = (angle<=(M_PI/2));
+  const bool thirdQuadrant = (angle>M_PI && angle<=(3*M_PI/2));
+  if (firstQuadrant || thirdQuadrant) {
+    rightLineX *= (1-lengthProportion); rightLineY *= lengthProportion;
+    leftLineX  *= lengthProportion;     leftLineY  *= (1-lengthProportion);
+  } else {
+    rightLineX *= lengthProportion;     rightLineY *= (1-lengthProportion);
+    leftLineX  *= (1-lengthProportion); leftLineY  *= lengthProportion;
+  }
+
+  return ArrowHead {
+    QPoint(originX, originY),
+    QPoint(originX+leftLineX, originY+leftLineY),
+    QPoint(originX+rightLineX, originY+rightLineY),
+  };
+}
+
+QColor invertColor(QColor color)
+{
+  color.setRed(255 - color.red());
+  color.setGreen(255 - color.green());
+  color.setBlue(255 - color.blue());
+
+  return color;
+}
+
+void invertColorPainter(QPainter *painter)
+{
+  QPen pen = painter->pen();
+  QColor color = invertColor(pen.color());
+
+  pen.setColor(color);
+  painter->setPen(pen);
+}
+
+ArrowHead getFreeFormArrowHead(const Form &freeForm)
+{
+  const int pointsCount = 8; // Number of points to take the average for the arrow head start
+  const int minPointDistance = 5; // Minimal pixel of the distance between the points for the average
+  const int lineSize = MAX_ARROWHEAD_LENGTH / 2;
+
+  if (freeForm.points.size() <= pointsCount) { // Too short
+    return ArrowHead {
+      QPoint(0,0),
+      QPoint(0,0),
+      QPoint(0,0)
+    };
+  }
+
+  // Get the points for the average
+  QList<QPoint> points;
+  points.append(freeForm.points.at(freeForm.points.size()-2));
+  for (int i=freeForm.points.size()-2; i>0; i--) { // It start from the penultimate to give more importance to that last point
+    if (points.size() == pointsCount) {
+      break;
+    }
+
+    const QPoint newPoint = freeForm.points.at(i);
+    const QPoint last = points.last();
+
+    float distance = hypot(newPoint.x() - last.x(), newPoint.y() - last.y());
+
+    if (distance > minPointDistance) {
+      points.append(newPoint);
+    }
+  }
+
+  QPoint start(0,0);
+  for (int i=0; i < points.size(); i++) {
+    start += points.at(i) / points.size();
+  }
+
+  return getArrowHead(
+        start.x(),
+        start.y(),
+        freeForm.points.last().x() - start.x(),
+        freeForm.points.last().y() - start.y(),
+        lineSize
+      );
+}
+
+// Position of a simple form (only two points) relative to the pixmap
+static void getPixmapFormPosition(const Form &form, int *x, int *y, int *w, int *h)
+{
+  const QPoint startPoint = form.points.at(0);
+  const QPoint endPoint   = form.points.at(1);
+
+  *x = startPoint.x();
+  *y = startPoint.y();
+  *w = endPoint.x() - startPoint.x();
+  *h = endPoint.y() - startPoint.y();
+}
+
+// Squared distance from the point (px, py) to the segment from a to b
+static inline float squaredDistanceToSegment(const float px, const float py, const QPoint a, const QPoint b)
+{
+  const float dx = b.x() - a.x();
+  const float dy = b.y() - a.y();
+  const float ox = px - a.x();
+  const float oy = py - a.y();
+
+  // Projection of the point onto the segment, clamped to its ends (the
+  // segments of length 0 use their start)
+  const float length = dx*dx + dy*dy;
+  float t = (length > 0.0f) ? (ox*dx + oy*dy) / length : 0.0f;
+  t = qMin(qMax(t, 0.0f), 1.0f);
+
+  const float ex = ox - t*dx;
+  const float ey = oy - t*dy;
+  return ex*ex + ey*ey;
+}
+
+bool isNearPolylineScalar(const QPoint *points, const int count, const QPointF point, const qreal distance)
+{
+  const float maxDistance = distance * distance; // Squared
+  for (int i=0; i < count-1; i++) {
+    if (squaredDistanceToSegment(point.x(), point.y(), points[i], points[i+1]) <= maxDistance) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool isNearPolyline(const QPoint *points, const int count, const QPointF point, const qreal distance)
+{
+  // The vector loads read the points as pairs of ints
+  static_assert(sizeof(QPoint) == 2 * sizeof(int), "QPoint must be two ints");
+
+  const float px = point.x();
+  const float py = point.y();
+  const float maxDistance = distance * distance; // Squared
+
+  // Same as squaredDistanceToSegment(), for 4 segments at once (from the
+  // points i..i+3 to i+1..i+4). The points are split into the x and y of each
+  // end while they're loaded
+  int i = 0;
+#if HIT_TEST_SSE2
+  const __m128 vpx = _mm_set1_ps(px);
+  const __m128 vpy = _mm_set1_ps(py);
+  const __m128 vmax = _mm_set1_ps(maxDistance);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one  = _mm_set1_ps(1.0f);
+  // The points are integers, so the segments that aren't empty have a length
+  // of 1 or more (and the empty ones have a projection of 0)
+  const __m128 minLength = _mm_set1_ps(0.5f);
+
+  for (; i+4 < count; i+=4) {
+    const int *a = reinterpret_cast<const int *>(points + i);
+    const __m128 a01 = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a)));     // x0 y0 x1 y1
+    const __m128 a23 = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 4))); // x2 y2 x3 y3
+    const __m128 b01 = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 2)));
+    const __m128 b23 = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 6)));
+
+    const __m128 ax = _mm_shuffle_ps(a01, a23, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 ay = _mm_shuffle_ps(a01, a23, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m128 dx = _mm_sub_ps(_mm_shuffle_ps(b01, b23, _MM_SHUFFLE(2, 0, 2, 0)), ax);
+    const __m128 dy = _mm_sub_ps(_mm_shuffle_ps(b01, b23, _MM_SHUFFLE(3, 1, 3, 1)), ay);
+    const __m128 ox = _mm_sub_ps(vpx, ax);
+    const __m128 oy = _mm_sub_ps(vpy, ay);
+
+    const __m128 length = _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), minLength);
+    __m128 t = _mm_div_ps(_mm_add_ps(_mm_mul_ps(ox, dx), _mm_mul_ps(oy, dy)), length);
+    t = _mm_min_ps(_mm_max_ps(t, zero), one);
+
+    const __m128 ex = _mm_sub_ps(ox, _mm_mul_ps(t, dx));
+    const __m128 ey = _mm_sub_ps(oy, _mm_mul_ps(t, dy));
+    const __m128 squared = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+
+    if (_mm_movemask_ps(_mm_cmple_ps(squared, vmax))) {
+      return true;
+    }
+  }
+#elif HIT_TEST_NEON
+  const float32x4_t vpx = vdupq_n_f32(px);
+  const float32x4_t vpy = vdupq_n_f32(py);
+  const float32x4_t vmax = vdupq_n_f32(maxDistance);
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t one  = vdupq_n_f32(1.0f);
+  // The points are integers, so the segments that aren't empty have a length
+  // of 1 or more (and the empty ones have a projection of 0)
+  const float32x4_t minLength = vdupq_n_f32(0.5f);
+
+  for (; i+4 < count; i+=4) {
+    // vld2q splits the x and the y of the points while loading them
+    const int32x4x2_t a = vld2q_s32(reinterpret_cast<const int32_t *>(points + i));
+    const int32x4x2_t b = vld2q_s32(reinterpret_cast<const int32_t *>(points + i + 1));
+
+    const float32x4_t ax = vcvtq_f32_s32(a.val[0]);
+    const float32x4_t ay = vcvtq_f32_s32(a.val[1]);
+    const float32x4_t dx = vsubq_f32(vcvtq_f32_s32(b.val[0]), ax);
+    const float32x4_t dy = vsubq_f32(vcvtq_f32_s32(b.val[1]), ay);
+    const float32x4_t ox = vsubq_f32(vpx, ax);
+    const float32x4_t oy = vsubq_f32(vpy, ay);
+
+    const float32x4_t length = vmaxq_f32(vmlaq_f32(vmulq_f32(dx, dx), dy, dy), minLength);
+    float32x4_t t = vdivq_f32(vmlaq_f32(vmulq_f32(ox, dx), oy, dy), length);
+    t = vminq_f32(vmaxq_f32(t, zero), one);
+
+    const float32x4_t ex = vmlsq_f32(ox, t, dx);
+    const float32x4_t ey = vmlsq_f32(oy, t, dy);
+    const float32x4_t squared = vmlaq_f32(vmulq_f32(ex, ex), ey, ey);
+
+    if (vmaxvq_u32(vcleq_f32(squared, vmax))) {
+      return true;
+    }
+  }
+#endif
+
+  // The rest of the segments (or all of them without SSE2 or NEON)
+  for (; i < count-1; i++) {
+    if (squaredDistanceToSegment(px, py, points[i], points[i+1]) <= maxDistance) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+QPainterPath freeFormOutline(const Form &freeForm)
+{
+  QPainterPath outline;
+  outline.setFillRule(Qt::WindingFill);
+
+  QPainterPathStroker stroker;
+  stroker.setCapStyle(Qt::RoundCap);
+  stroker.setJoinStyle(Qt::RoundJoin);
+
+  // The consecutive segments with the same width are stroked together. All
+  // the strokes have the same orientation, so their union is filled with the
+  // winding rule (without computing the intersections)
+  for (int start=0; start < freeForm.points.size()-1; ) {
+    const int width = freeForm.penWidths.at(start);
+    int end = start + 1;
+    while (end < freeForm.points.size()-1 && freeForm.penWidths.at(end) == width) end++;
+
+    QPainterPath segments(freeForm.points.at(start));
+    for (int i=start+1; i<=end; i++) {
+      segments.lineTo(freeForm.points.at(i));
+    }
+
+    stroker.setWidth(width);
+    outline.addPath(stroker.createStroke(segments));
+
+    start = end;
+  }
+
+  return outline;
+}
+
+int simplifyStroke(QList<QPoint> *points, QList<int> *widths, const qreal tolerance)
+{
+  const int count = points->size();
+  if (count < 3 || widths->size() != count-1) {
+    return count;
+  }
+
+  QList<bool> keep(count, false);
+  keep[0] = true;
+  keep[count-1] = true;
+  for (int i=1; i<count-1; i++) {
+    if (widths->at(i-1) != widths->at(i)) {
+      keep[i] = true;
+    }
+  }
+
+  // Ranges between two kept points that still have to be simplified (without
+  // recursion, because the strokes can have thousands of points)
+  QList<QPair<int, int>> ranges;
+  int start = 0;
+  for (int i=1; i<count; i++) {
+    if (!keep.at(i)) continue;
+    if (i - start > 1) ranges.append(qMakePair(start, i));
+    start = i;
+  }
+
+  const qreal maxDistance = tolerance * tolerance; // Squared
+  while (!ranges.isEmpty()) {
+    const QPair<int, int> range = ranges.takeLast();
+    const QPointF first = points->at(range.first);
+    const QPointF line  = QPointF(points->at(range.second)) - first;
+    const qreal length  = QPointF::dotProduct(line, line); // Squared
+
+    // Farthest point from the segment (not from the infinite line, so the
+    // tips of the strokes that turn back aren't removed)
+    int farthest = -1;
+    qreal farthestDistance = maxDistance;
+    for (int i=range.first+1; i<range.second; i++) {
+      const QPointF point = QPointF(points->at(i)) - first;
+      const qreal t = (length > 0) ? qBound(0.0, QPointF::dotProduct(point, line) / length, 1.0) : 0.0;
+      const QPointF offset = point - line * t;
+      const qreal distance = QPointF::dotProduct(offset, offset);
+
+      if (distance > farthestDistance) {
+        farthestDistance = distance;
+        farthest = i;
+      }
+    }
+
+    if (farthest != -1) {
+      keep[farthest] = true;
+      ranges.append(qMakePair(range.first, farthest));
+      ranges.append(qMakePair(farthest, range.second));
+    }
+  }
+
+  // The width of a kept point is the width of the segment that starts there
+  int kept = 0;
+  for (int i=0; i<count; i++) {
+    if (!keep.at(i)) continue;
+
+    (*points)[kept] = points->at(i);
+    if (i < count-1) (*widths)[kept] = widths->at(i);
+    kept++;
+  }
+  points->resize(kept);
+  widths->resize(kept-1);
+
+  return kept;
+}
+
+void drawForm(QPainter *pixmapPainter, const Form &f, const bool hovered)
+{
+  if (f.deleted) {
+    return;
+  }
+
+  int x, y, w, h;
+  pixmapPainter->setPen(f.pen);
+  if (hovered) invertColorPainter(pixmapPainter);
+
+  switch (f.type) {
+    case RECTANGLE:
+      getPixmapFormPosition(f, &x, &y, &w, &h);
+
+      if (f.highlight) {
+        QColor color = pixmapPainter->pen().color();
+        color.setAlpha(HIGHLIGHT_ALPHA); // Transparency
+        QPainterPath background;
+        background.addRoundedRect(x, y, w, h, RECT_ROUNDNESS, RECT_ROUNDNESS);
+        pixmapPainter->fillPath(background, color);
+      }
+
+      pixmapPainter->drawRoundedRect(fixQRect(x, y, w, h), RECT_ROUNDNESS, RECT_ROUNDNESS);
+      break;
+
+    case LINE:
+      getPixmapFormPosition(f, &x, &y, &w, &h);
+
+      // Draw a wider semi-transparent line behind the line as the highlight
+      if (f.highlight) {
+        QPen oldPen = pixmapPainter->pen();
+
+        // Change the color and width of the pen
+        QPen newPen = oldPen;
+        QColor color = oldPen.color(); color.setAlpha(HIGHLIGHT_ALPHA); newPen.setColor(color);
+        newPen.setWidth(newPen.width() * 4);
+        pixmapPainter->setPen(newPen);
+
+        pixmapPainter->drawLine(x, y, x+w, y+h);
+
+        // Reset pen
+        pixmapPainter->setPen(oldPen);
+      }
+
+      if (f.arrow) {
+        ArrowHead head = getArrowHead(x, y, w, h, 0);
+        pixmapPainter->drawLine(head.startPoint, head.rightLineEnd);
+        pixmapPainter->drawLine(head.startPoint, head.leftLineEnd);
+      }
+
+      pixmapPainter->drawLine(x, y, x+w, y+h);
+      break;
+
+    case ELLIPSE:
+      getPixmapFormPosition(f, &x, &y, &w, &h);
+
+      if (f.highlight) {
+        QColor color = pixmapPainter->pen().color();
+        color.setAlpha(HIGHLIGHT_ALPHA); // Transparency
+        QPainterPath background;
+        background.addEllipse(x, y, w, h);
+        pixmapPainter->fillPath(background, color);
+      }
+
+      pixmapPainter->drawEllipse(x, y, w, h);
+      break;
+
+    case TEXT:
+      // If the last one is currently active (user is typing), draw it in the
+      // "active text" `if` statement
+      if (!f.active) {
+        updateFontSize(pixmapPainter);
+        getPixmapFormPosition(f, &x, &y, &w, &h);
+
+        if (f.highlight) {
+          QColor color = pixmapPainter->pen().color();
+          color.setAlpha(HIGHLIGHT_ALPHA); // Transparency
+          QPainterPath background;
+          background.addRoundedRect(x, y, w, h, RECT_ROUNDNESS, RECT_ROUNDNESS);
+          pixmapPainter->fillPath(background, color);
+          pixmapPainter->drawRoundedRect(fixQRect(x, y, w, h), RECT_ROUNDNESS, RECT_ROUNDNESS);
+        }
+
+        QString text = f.text;
+        QRect textRect = fixQRect(x, y, w, h);
+        // Don't draw the text over the border (when highlighted)
+        textRect.setX(textRect.x() + pixmapPainter->pen().width()/2);
+        textRect.setY(textRect.y() + pixmapPainter->pen().width()/2);
+        // If the inside border is bigger than the width, don't overflow to negative width
+        if (abs(textRect.width()) > pixmapPainter->pen().width()/2) {
+          textRect.setWidth(textRect.width() - pixmapPainter->pen().width()/2);
+        } else {
+          textRect.setWidth(0);
+        }
+        // If the inside border is bigger than the height, don't overflow to negative height
+        if (abs(textRect.height()) > pixmapPainter->pen().width()/2) {
+          textRect.setHeight(textRect.height() - pixmapPainter->pen().width()/2);
+        } else {
+          textRect.setHeight(0);
+        }
+
+        pixmapPainter->drawText(textRect, Qt::AlignCenter | Qt::TextWordWrap, text);
+        break;
+      }
+
+    case FREEFORM:
+      // If the is currently active, draw it in the "active forms" switch
+      if (!f.active) {
+        // Draw the free form with or without the highlight
+        if (f.highlight) {
+          QPolygon polygon(f.points);
+
+          // Highlight
+          QColor color = pixmapPainter->pen().color();
+          color.setAlpha(HIGHLIGHT_ALPHA); // Transparency
+          QPainterPath background;
+          background.addPolygon(polygon);
+          pixmapPainter->fillPath(background, color);
+          // You can't draw a highlighted arrow in free form
+
+          pixmapPainter->drawPolygon(polygon);
+        } else {
+          // The forms that weren't drawn in the widget (like the ones rendered
+          // headlessly) don't have the outline yet
+          const QPainterPath outline = f.outline.isEmpty() ? freeFormOutline(f) : f.outline;
+          pixmapPainter->fillPath(outline, pixmapPainter->pen().color());
+
+          if (f.arrow) {
+            changePenWidth(pixmapPainter, f.penWidths.last());
+            ArrowHead head = getFreeFormArrowHead(f);
+            pixmapPainter->drawLine(head.startPoint, head.rightLineEnd);
+            pixmapPainter->drawLine(head.startPoint, head.leftLineEnd);
+          }
+        }
+      }
+      break;
+  }
+}
+
+// The background of the exported images (like ZoomWidget::getExportBackground()).
+// In live mode, the desktop was behind the window, so it's transparent (the
+// source can have a capture of the zoom)
+static QImage projectBackground(const Project &project)
+{
+  if (project.liveMode) {
+    QImage background(project.source.size(), QImage::Format_ARGB32_Premultiplied);
+    background.fill(Qt::transparent);
+    return background;
+  }
+
+  return project.source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+QImage renderProject(const Project &project)
+{
+  QImage image = projectBackground(project);
+
+  QPainter painter(&image);
+  for (int i=0; i<project.forms.size(); i++) {
+    drawForm(&painter, project.forms.at(i), false);
+  }
+  painter.end();
+
+  return image;
+}
+
+QByteArray renderThumbnail(const Project &project)
+{
+  const QSize size = project.source.size().scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio);
+  if (size.isEmpty()) {
+    return QByteArray();
+  }
+
+  QImage thumbnail(size, QImage::Format_ARGB32_Premultiplied);
+  thumbnail.fill(Qt::transparent);
+
+  // Draw everything scaled down, instead of rendering the project in its full
+  // size and then scaling it
+  QPainter painter(&thumbnail);
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.setRenderHint(QPainter::SmoothPixmapTransform);
+  painter.scale((qreal)size.width()  / (qreal)project.source.width(),
+                (qreal)size.height() / (qreal)project.source.height());
+  if (!project.liveMode) {
+    painter.drawImage(0, 0, project.source);
+  }
+  for (int i=0; i<project.forms.size(); i++) {
+    drawForm(&painter, project.forms.at(i), false);
+  }
+  painter.end();
+
+  QByteArray bytes;
+  QBuffer buffer(&bytes); buffer.open(QIODevice::WriteOnly);
+  thumbnail.save(&buffer, THUMBNAIL_FORMAT);
+
+  return bytes;
+}
+
+// Renders the rows [top, top + height) of the scaled area
+static QImage renderScaledBand(const Project &project, const QRect area, const int scale, const int top, const int height)
+{
+  QImage band(area.width() * scale, height, QImage::Format_ARGB32_Premultiplied);
+  band.fill(Qt::transparent);
+
+  // The drawings are drawn again with the scale, instead of scaling the pixels
+  // of the pixmap (so they're sharp). The painter only rasterizes what falls
+  // inside the band
+  QPainter painter(&band);
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.setRenderHint(QPainter::TextAntialiasing);
+  painter.translate(0, -top);
+  painter.scale(scale, scale);
+  painter.translate(-area.topLeft());
+  painter.drawImage(0, 0, project.source);
+  for (int i=0; i<project.forms.size(); i++) {
+    drawForm(&painter, project.forms.at(i), false);
+  }
+  painter.end();
+
+  return band;
+}
+
+static int scaledBandHeight(const QRect area, const int scale)
+{
+  return qMax(1, EXPORT_BAND_PIXELS / (area.width() * scale));
+}
+
+bool renderScaledPng(const Project &project, const QRect area, const int scale, QIODevice *device, const int compressionLevel)
+{
+  const QSize size = area.size() * scale;
+  const int bandHeight = scaledBandHeight(area, scale);
+
+  PngWriter writer(device, size, project.source.hasAlphaChannel(), compressionLevel);
+  for (int top=0; top<size.height(); top+=bandHeight) {
+    const int height = qMin(bandHeight, size.height() - top);
+    if (!writer.writeRows(renderScaledBand(project, area, scale, top, height))) {
+      return false;
+    }
+  }
+
+  return writer.finish();
+}
+
+QImage renderScaledImage(const Project &project, const QRect area, const int scale)
+{
+  QImage image(area.size() * scale, QImage::Format_ARGB32_Premultiplied);
+  if (image.isNull()) {
+    return QImage();
+  }
+
+  const int bandHeight = scaledBandHeight(area, scale);
+  QPainter painter(&image);
+  painter.setCompositionMode(QPainter::CompositionMode_Source);
+  for (int top=0; top<image.height(); top+=bandHeight) {
+    const int height = qMin(bandHeight, image.height() - top);
+    painter.drawImage(0, top, renderScaledBand(project, area, scale, top, height));
+  }
+  painter.end();
+
+  return image;
+}
+
+struct RenderJob {
+  QString input;  // '.zoomme' file
+  QString output; // Image
+  bool success;
+};
+
+// Executed in the threads of the pool
+static void renderJob(RenderJob &job)
+{
+  job.success = false;
+
+  QFile file(job.input);
+  if (!file.open(QIODevice::ReadOnly)) {
+    fprintf(stderr, "[ERROR] Couldn't open the file: %s\n", QSTRING_TO_STRING(job.input));
+    return;
+  }
+
+  Project project;
+  QDataStream in(&file);
+  const ProjectReadStatus status = readProject(&in, &project);
+  if (status != PROJECT_READ_OK) {
+    fprintf(stderr, "[ERROR] %s: %s\n", projectReadError(status), QSTRING_TO_STRING(job.input));
+    return;
+  }
+
+  // The vector images of live mode don't have a background (see
+  // projectBackground())
+  const QRect area = project.source.rect();
+  if (project.liveMode && isVectorFormat(QFileInfo(job.output).suffix())) {
+    project.source = QImage();
+  }
+
+  const bool saved = (isVectorFormat(QFileInfo(job.output).suffix()))
+                     ? writeVectorImage(project, area, job.output)
+                     : writeImage(renderProject(project), job.output);
+  if (!saved) {
+    fprintf(stderr, "[ERROR] Couldn't save the picture to: %s\n", QSTRING_TO_STRING(job.output));
+    return;
+  }
+
+  job.success = true;
+  fprintf(stdout, "[INFO] Rendered %s --> %s\n", QSTRING_TO_STRING(job.input), QSTRING_TO_STRING(job.output));
+}
+
+int renderProjectFiles(const QList<QString> inputs, const QString output, const QString imgExt)
+{
+  const QString extension = (imgExt.isEmpty()) ? "png" : imgExt;
+  if (!isImageFormatSupported(extension)) {
+    fprintf(stderr, "[ERROR] Image extension not supported\n");
+    return EXIT_FAILURE;
+  }
+
+  const bool toFolder = (inputs.size() > 1) || QFileInfo(output).isDir();
+  if (!output.isEmpty() && toFolder && !QFileInfo(output).isDir()) {
+    fprintf(stderr, "[ERROR] When rendering more than one file, the output should be an existing folder\n");
+    return EXIT_FAILURE;
+  }
+
+  QList<RenderJob> jobs;
+  for (int i=0; i<inputs.size(); i++) {
+    const QFileInfo info(inputs.at(i));
+    const QString fileName = info.completeBaseName() + "." + extension;
+
+    QString path;
+    if (output.isEmpty()) {
+      path = info.dir().absoluteFilePath(fileName);
+    } else if (toFolder) {
+      path = QDir(output).absoluteFilePath(fileName);
+    } else {
+      path = output;
+    }
+
+    jobs.append(RenderJob{
+        .input   = inputs.at(i),
+        .output  = path,
+        .success = false
+      });
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  QtConcurrent::blockingMap(jobs, renderJob);
+  const qint64 elapsed = timer.elapsed();
+
+  int rendered = 0;
+  for (int i=0; i<jobs.size(); i++) {
+    if (jobs.at(i).success) rendered++;
+  }
+
+  // Throughput of the renderer
+  fprintf(stdout, "[INFO] Rendered %d/%lld files in %lld ms (%.2f files/sec using %d threads)\n",
+          rendered,
+          (long long)jobs.size(),
+          (long long)elapsed,
+          (elapsed > 0) ? (rendered * 1000.0 / elapsed) : 0.0,
+          QThreadPool::globalInstance()->maxThreadCount());
+
+  return (rendered == jobs.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int extractProjectThumbnail(const QString input, QString output)
+{
+  if (output.isEmpty()) {
+    const QFileInfo info(input);
+    output = info.dir().absoluteFilePath(info.completeBaseName() + ".thumbnail." + QString(THUMBNAIL_FORMAT).toLower());
+  }
+
+  QFile file(input);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+    fprintf(stderr, "[ERROR] Couldn't open the file: %s\n", QSTRING_TO_STRING(input));
+    return EXIT_FAILURE;
+  }
+
+  QByteArray thumbnail;
+  if (!readProjectThumbnail(&file, &thumbnail)) {
+    // Saved by an older version of ZoomMe, so the whole project is needed
+    fprintf(stdout, "[INFO] The file doesn't contain a thumbnail. Rendering it...\n");
+
+    Project project;
+    file.seek(0);
+    QDataStream in(&file);
+    const ProjectReadStatus status = readProject(&in, &project);
+    if (status != PROJECT_READ_OK) {
+      fprintf(stderr, "[ERROR] %s: %s\n", projectReadError(status), QSTRING_TO_STRING(input));
+      return EXIT_FAILURE;
+    }
+
+    thumbnail = renderThumbnail(project);
+  }
+
+  QFile outputFile(output);
+  if (!outputFile.open(QIODevice::WriteOnly) || outputFile.write(thumbnail) != thumbnail.size()) {
+    fprintf(stderr, "[ERROR] Couldn't save the thumbnail to: %s\n", QSTRING_TO_STRING(output));
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stdout, "[INFO] Thumbnail saved: %s\n", QSTRING_TO_STRING(output));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+
+#include "zoomwidget.hpp"
+#include "project.hpp"
+#include <QPainter>
+#include <QPainterPath>
+#include <QImage>
+#include <QList>
+#include <QString>
+#include <QRect>
+#include <QIODevice>
+
+// These functions don't depend on the state of the widget, so they can be used
+// to render the drawings outside of it (for example, from other threads when
+// rendering headlessly)
+
+QRect fixQRect(int x, int y, int width, int height);
+void updateFontSize(QPainter *painter);
+void changePenWidth(QPainter *painter, int width);
+QColor invertColor(QColor color);
+void invertColorPainter(QPainter *painter);
+
+// If the lineLength is 0, it will be calculated with the hypotenuse (the line)
+ArrowHead getArrowHead(const int x, const int y, const int width, const int height, int lineLength);
+ArrowHead getFreeFormArrowHead(const Form &freeForm);
+// If the point is at most at the distance of any of the lines between the
+// consecutive points (for the hit tests of the lines and the free forms)
+bool isNearPolyline(const QPoint *points, const int count, const QPointF point, const qreal distance);
+// Same as isNearPolyline(), one segment at a time (without SSE2 or NEON). It's
+// the reference that the self-test compares it with
+bool isNearPolylineScalar(const QPoint *points, const int count, const QPointF point, const qreal distance);
+// Area that the free form covers when each segment is drawn with its width
+// (with round joins). It should be built once and kept in Form::outline
+QPainterPath freeFormOutline(const Form &freeForm);
+// Removes the points of the stroke that are closer than the tolerance to the
+// line between the points that are kept (Ramer-Douglas-Peucker). widths has
+// the width of each segment (one less than the points), and the points where
+// the width changes are always kept, so each remaining segment keeps the
+// width of the segments that it replaces. Returns the amount of points kept
+int simplifyStroke(QList<QPoint> *points, QList<int> *widths, const qreal tolerance);
+
+// Draws a saved form with the painter of the pixmap (the points of the form
+// are relative to the pixmap). Deleted and active forms are not drawn. If
+// hovered is true, the colors of the form are inverted
+void drawForm(QPainter *pixmapPainter, const Form &form, const bool hovered);
+
+// Returns the background of the project with the drawings on top (like the
+// pixmap that is exported when pressing 's')
+QImage renderProject(const Project &project);
+// Same as renderProject(), but scaled down to THUMBNAIL_SIZE and encoded with
+// THUMBNAIL_FORMAT
+QByteArray renderThumbnail(const Project &project);
+
+// Renders the area of the project (in pixmap coordinates) with the drawings
+// drawn again at 'scale' times the resolution of the pixmap. It's rendered in
+// bands of EXPORT_BAND_PIXELS pixels that are encoded as soon as they're drawn,
+// so the whole scaled image is never in memory
+bool renderScaledPng(const Project &project, const QRect area, const int scale, QIODevice *device, const int compressionLevel);
+// Same as renderScaledPng(), but it returns the whole image (for the formats
+// that can't be written band by band)
+QImage renderScaledImage(const Project &project, const QRect area, const int scale);
+
+// Renders the '.zoomme' files to images in parallel, without opening a window.
+// If the output is empty, each image is saved next to its '.zoomme' file. If
+// the output is a folder (or there's more than one input), the images are
+// saved in that folder. Otherwise, the output is the path of the image.
+// Returns the exit status of the program
+int renderProjectFiles(const QList<QString> inputs, const QString output, const QString imgExt);
+
+// Saves the thumbnail of the '.zoomme' file in the output (by default, next to
+// the file). It only reads the header of the file, unless the file was saved
+// by an older version (without a thumbnail), where it has to render it.
+// Returns the exit status of the program
+int extractProjectThumbnail(const QString input, QString output);
+
+#endif // RENDERER_HPP
@@ -0,0 +1,101 @@
+#!/bin/sh
+# Checks the zoom of the live mode in a virtual X server (Xvfb), which has no
+# compositor: a window under ZoomMe changes its color every second, and the
+# magnified center of the screen has to follow it (if ZoomMe captured itself,
+# or stopped capturing, it would stay the same)
+#
+# Needs: Xvfb, xdotool, ImageMagick (import), a C compiler and libX11
+# Usage: scripts/check-live-zoom.sh [path to zoomme] (default: ./zoomme)
+
+ZOOMME=${1:-./zoomme}
+DISPLAY_NUMBER=:97
+WIDTH=800
+HEIGHT=600
+TMP=$(mktemp -d)
+
+cleanup() {
+  kill $ZOOMME_PID $CLIENT_PID $XVFB_PID 2>/dev/null
+  rm -rf "$TMP"
+}
+trap cleanup EXIT
+
+for tool in Xvfb xdotool import cc; do
+  if ! command -v $tool >/dev/null; then
+    echo "[ERROR] '$tool' is needed"
+    exit 1
+  fi
+done
+
+# A window that covers the screen and alternates between red and blue
+cat > "$TMP/blink.c" <<EOF
+#include <X11/Xlib.h>
+#include <unistd.h>
+int main(void)
+{
+  Display *display = XOpenDisplay(0);
+  if (!display) return 1;
+  int screen = DefaultScreen(display);
+  Colormap colormap = DefaultColormap(display, screen);
+  XColor red, blue, exact;
+  XAllocNamedColor(display, colormap, "red", &red, &exact);
+  XAllocNamedColor(display, colormap, "blue", &blue, &exact);
+  Window window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, $WIDTH, $HEIGHT, 0, 0, red.pixel);
+  XMapWindow(display, window);
+  for (int i=0; ; i++) {
+    XSetWindowBackground(display, window, (i % 2) ? blue.pixel : red.pixel);
+    XClearWindow(display, window);
+    XFlush(display);
+    sleep(1);
+  }
+}
+EOF
+if ! cc -o "$TMP/blink" "$TMP/blink.c" -lX11; then
+  echo "[ERROR] Couldn't compile the test window"
+  exit 1
+fi
+
+Xvfb $DISPLAY_NUMBER -screen 0 ${WIDTH}x${HEIGHT}x24 -nolisten tcp &
+XVFB_PID=$!
+export DISPLAY=$DISPLAY_NUMBER
+sleep 1
+
+"$TMP/blink" &
+CLIENT_PID=$!
+sleep 1
+
+"$ZOOMME" -l &
+ZOOMME_PID=$!
+sleep 2
+
+# Zoom in at the center
+xdotool mousemove $((WIDTH/2)) $((HEIGHT/2))
+for i in 1 2 3 4 5; do
+  xdotool click 4
+done
+sleep 1
+
+# The color of the center, several times (faster than the window changes)
+COLORS=""
+for i in 1 2 3 4 5 6 7 8; do
+  COLOR=$(import -window root -crop 1x1+$((WIDTH/2))+$((HEIGHT/2)) -depth 8 txt:- | tail -n 1 | awk '{print $3}')
+  COLORS="$COLORS $COLOR"
+  sleep 0.5
+done
+echo "[INFO] Colors of the center:$COLORS"
+
+if ! kill -0 $ZOOMME_PID 2>/dev/null; then
+  echo "[ERROR] ZoomMe exited"
+  exit 1
+fi
+
+DISTINCT=$(echo $COLORS | tr ' ' '\n' | sort -u | wc -l)
+if [ "$DISTINCT" -lt 2 ]; then
+  echo "[ERROR] The magnified desktop didn't change"
+  exit 1
+fi
+if echo $COLORS | tr ' ' '\n' | grep -qv -e '#FF0000' -e '#0000FF'; then
+  echo "[ERROR] The magnified desktop has colors that aren't of the window under it"
+  exit 1
+fi
+
+echo "[SUCCESS] The magnified desktop follows the window under ZoomMe"
@@ -0,0 +1,322 @@
+#include "selftest.hpp"
+#include "pngencoder.hpp"
+#include "qoi.hpp"
+#include "project.hpp"
+#include "renderer.hpp"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QDataStream>
+#include <QImage>
+#include <QList>
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// The random data is always the same, so a failure can be repeated
+#define SELF_TEST_SEED 0x5A4F4F4D
+#define HIT_TEST_CASES 20000
+// The hit tests whose point is this close to the distance (in pixels) aren't
+// compared, because the rounding of the floats can put them on either side
+#define HIT_TEST_TOLERANCE 0.001
+
+// Image with the cases that the encoders treat differently: solid areas (runs),
+// gradients (small differences) and noise. Half of the pixels are translucent
+// if it has alpha
+static QImage testImage(const QSize size, const bool alpha, QRandomGenerator *rng)
+{
+  QImage image(size, (alpha) ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+  for (int y=0; y<size.height(); y++) {
+    QRgb *row = reinterpret_cast<QRgb *>(image.scanLine(y));
+    for (int x=0; x<size.width(); x++) {
+      const int a = (alpha && (x + y) % 2) ? (x * 7 + y) % 256 : 255;
+      if (x < size.width() / 4) {
+        row[x] = qRgba(40, 80, 120, a);
+      } else if ((x * 31 + y * 17) % 11 == 0) {
+        row[x] = qRgba(rng->bounded(256), rng->bounded(256), rng->bounded(256), a);
+      } else {
+        row[x] = qRgba(x % 256, y % 256, (x + y) % 256, a);
+      }
+    }
+  }
+  return image;
+}
+
+// The decoders return other formats, so both are converted to the format of
+// the data that the encoders write
+static bool sameImage(const QImage &decoded, const QImage &original)
+{
+  const QImage::Format format = (original.hasAlphaChannel()) ? QImage::Format_RGBA8888 : QImage::Format_RGBX8888;
+  return !decoded.isNull() && decoded.convertToFormat(format) == original.convertToFormat(format);
+}
+
+static bool checkPngEncoder(QRandomGenerator *rng)
+{
+  // Big enough to be split in several strips
+  const QSize size(701, 433);
+  bool success = true;
+
+  for (const bool alpha : {false, true}) {
+    const QImage image = testImage(size, alpha, rng);
+    const char *kind = (alpha) ? "with alpha" : "opaque";
+
+    QByteArray bytes;
+    QBuffer buffer(&bytes); buffer.open(QIODevice::WriteOnly);
+    if (!writePng(image, &buffer) || !sameImage(QImage::fromData(bytes, "PNG"), image)) {
+      fprintf(stderr, "[ERROR] PNG (%s): The decoded image is different from the original\n", kind);
+      success = false;
+    }
+
+    // Band by band, with bands that don't divide the height
+    QByteArray bandBytes;
+    QBuffer bandBuffer(&bandBytes); bandBuffer.open(QIODevice::WriteOnly);
+    PngWriter writer(&bandBuffer, size, alpha, 1);
+    bool written = true;
+    for (int y=0; y<size.height(); y+=37) {
+      written = written && writer.writeRows(image.copy(0, y, size.width(), qMin(37, size.height() - y)));
+    }
+    if (!written || !writer.finish() || !sameImage(QImage::fromData(bandBytes, "PNG"), image)) {
+      fprintf(stderr, "[ERROR] PNG (%s, band by band): The decoded image is different from the original\n", kind);
+      success = false;
+    }
+  }
+
+  if (success) fprintf(stdout, "[INFO] PNG: The encoded images decode to the same pixels\n");
+  return success;
+}
+
+static bool checkQoiCodec(QRandomGenerator *rng)
+{
+  bool success = true;
+
+  for (const bool alpha : {false, true}) {
+    const QImage image = testImage(QSize(389, 257), alpha, rng);
+    if (!sameImage(decodeQoi(encodeQoi(image)), image)) {
+      fprintf(stderr, "[ERROR] QOI (%s): The decoded image is different from the original\n", (alpha) ? "with alpha" : "opaque");
+      success = false;
+    }
+  }
+
+  if (success) fprintf(stdout, "[INFO] QOI: The images are encoded and decoded without losses\n");
+  return success;
+}
+
+static Form testForm(const FormType type, const QList<QPoint> points, const QPen pen)
+{
+  Form form;
+  form.type      = type;
+  form.points    = points;
+  form.pen       = pen;
+  form.highlight = false;
+  form.arrow     = false;
+  form.deleted   = false;
+  form.active    = false;
+  form.caretPos  = 0;
+  return form;
+}
+
+static bool sameForm(const Form &a, const Form &b)
+{
+  return a.type      == b.type
+      && a.points    == b.points
+      && a.pen       == b.pen
+      && a.highlight == b.highlight
+      && a.arrow     == b.arrow
+      && a.deleted   == b.deleted
+      && a.active    == b.active
+      && a.penWidths == b.penWidths
+      && a.caretPos  == b.caretPos
+      && a.text      == b.text;
+}
+
+static bool sameProject(const Project &a, const Project &b)
+{
+  if (a.forms.size() != b.forms.size()) {
+    return false;
+  }
+  for (int i=0; i<a.forms.size(); i++) {
+    if (!sameForm(a.forms.at(i), b.forms.at(i))) {
+      return false;
+    }
+  }
+
+  return a.thumbnail      == b.thumbnail
+      && a.windowSize     == b.windowSize
+      && sameImage(a.source, b.source)
+      && a.originalSize   == b.originalSize
+      && a.name           == b.name
+      && a.imageExt       == b.imageExt
+      && a.videoExt       == b.videoExt
+      && a.zoommeExt      == b.zoommeExt
+      && a.liveMode       == b.liveMode
+      && a.drawMode       == b.drawMode
+      && a.activePen      == b.activePen
+      && a.highlight      == b.highlight
+      && a.deletedHistory == b.deletedHistory;
+}
+
+static ProjectReadStatus readProjectBytes(const QByteArray &bytes, Project *project)
+{
+  QBuffer buffer;
+  buffer.setData(bytes);
+  buffer.open(QIODevice::ReadOnly);
+  QDataStream in(&buffer);
+  return readProject(&in, project);
+}
+
+static bool checkProjectFile(QRandomGenerator *rng)
+{
+  Project project;
+  project.thumbnail      = QByteArray("Not a real thumbnail");
+  project.windowSize     = QSize(1280, 720);
+  project.source         = testImage(QSize(320, 180), false, rng);
+  project.originalSize   = QSize(320, 180);
+  project.name           = "Self-test";
+  project.imageExt       = "png";
+  project.videoExt       = "mp4";
+  project.zoommeExt      = "zoomme";
+  project.liveMode       = false;
+  project.drawMode       = FREEFORM;
+  project.activePen      = QPen(QColor(255, 0, 0), 4);
+  project.highlight      = true;
+  project.deletedHistory = {1};
+
+  project.forms.append(testForm(LINE, {QPoint(10, 10), QPoint(200, 150)}, QPen(QColor(0, 255, 0), 2)));
+  project.forms.last().arrow = true;
+
+  project.forms.append(testForm(RECTANGLE, {QPoint(30, 20), QPoint(90, 70)}, QPen(QColor(0, 0, 255), 8)));
+  project.forms.last().deleted = true;
+
+  project.forms.append(testForm(ELLIPSE, {QPoint(100, 40), QPoint(60, 90)}, QPen(QColor(255, 255, 0), 6)));
+  project.forms.last().highlight = true;
+
+  project.forms.append(testForm(TEXT, {QPoint(5, 100), QPoint(300, 170)}, QPen(QColor(255, 255, 255), 3)));
+  project.forms.last().text = "Multi-line\ntext with ünicode";
+  project.forms.last().caretPos = 4;
+
+  Form freeForm = testForm(FREEFORM, {}, QPen(QColor(255, 0, 255), 5));
+  for (int i=0; i<50; i++) {
+    freeForm.points.append(QPoint(rng->bounded(320), rng->bounded(180)));
+    if (i > 0) freeForm.penWidths.append(rng->bounded(1, 12));
+  }
+  freeForm.arrow = true;
+  project.forms.append(freeForm);
+
+  QByteArray bytes;
+  QBuffer buffer(&bytes); buffer.open(QIODevice::WriteOnly);
+  QDataStream out(&buffer);
+  writeProject(&out, project);
+
+  bool success = true;
+  Project restored;
+  const ProjectReadStatus status = readProjectBytes(bytes, &restored);
+  if (status != PROJECT_READ_OK) {
+    fprintf(stderr, "[ERROR] Project: The saved project can't be read. %s\n", projectReadError(status));
+    success = false;
+  } else if (!sameProject(project, restored)) {
+    fprintf(stderr, "[ERROR] Project: The project that was read is different from the saved one\n");
+    success = false;
+  }
+
+  // The broken files have to be reported with their own error
+  QByteArray newer = bytes;
+  qToBigEndian<quint32>(PROJECT_VERSION + 1, newer.data() + sizeof(quint32));
+  const struct {
+    const char *name;
+    QByteArray bytes;
+    ProjectReadStatus expected;
+  } brokenFiles[] = {
+    {"not a ZoomMe file", QByteArray("This isn't a ZoomMe file"), PROJECT_READ_INVALID},
+    {"newer version",     newer,                                  PROJECT_READ_NEWER_VERSION},
+    {"truncated",         bytes.left(bytes.size() - 3),           PROJECT_READ_TRUNCATED},
+    {"data left",         bytes + QByteArray("left"),             PROJECT_READ_DATA_LEFT},
+  };
+  for (const auto &broken : brokenFiles) {
+    Project ignored;
+    const ProjectReadStatus brokenStatus = readProjectBytes(broken.bytes, &ignored);
+    if (brokenStatus != broken.expected) {
+      fprintf(stderr, "[ERROR] Project (%s): Expected \"%s\", but got \"%s\"\n",
+              broken.name, projectReadError(broken.expected), projectReadError(brokenStatus));
+      success = false;
+    }
+  }
+
+  if (success) fprintf(stdout, "[INFO] Project: The saved forms are read back the same, and the broken files are reported\n");
+  return success;
+}
+
+// Distance from the point to the nearest segment, with doubles
+static double distanceToPolyline(const QList<QPoint> &points, const QPointF point)
+{
+  double nearest = INFINITY;
+  for (int i=0; i < points.size()-1; i++) {
+    const QPointF a = points.at(i);
+    const QPointF d = QPointF(points.at(i+1)) - a;
+    const QPointF o = point - a;
+    const double length = QPointF::dotProduct(d, d);
+    const double t = (length > 0) ? qBound(0.0, QPointF::dotProduct(o, d) / length, 1.0) : 0.0;
+    const QPointF e = o - t*d;
+    nearest = qMin(nearest, sqrt(QPointF::dotProduct(e, e)));
+  }
+  return nearest;
+}
+
+static bool checkHitTest(QRandomGenerator *rng)
+{
+  int compared = 0;
+  for (int i=0; i<HIT_TEST_CASES; i++) {
+    // Up to 4 vector iterations and the rest, with repeated points (segments
+    // of length 0)
+    QList<QPoint> points;
+    const int count = rng->bounded(24);
+    for (int p=0; p<count; p++) {
+      if (p > 0 && rng->bounded(5) == 0) {
+        points.append(points.last());
+      } else {
+        points.append(QPoint(rng->bounded(-40, 41), rng->bounded(-40, 41)));
+      }
+    }
+    const QPointF point(rng->generateDouble() * 120 - 60, rng->generateDouble() * 120 - 60);
+    const qreal distance = rng->generateDouble() * 15;
+
+    const double exact = distanceToPolyline(points, point);
+    if (fabs(exact - distance) < HIT_TEST_TOLERANCE) {
+      continue;
+    }
+
+    const bool expected = exact <= distance;
+    const bool vector = isNearPolyline(points.constData(), points.size(), point, distance);
+    const bool scalar = isNearPolylineScalar(points.constData(), points.size(), point, distance);
+    if (vector != expected || scalar != expected) {
+      fprintf(stderr, "[ERROR] Hit test: Point (%f, %f), distance %f, %lld points: vector %d, scalar %d, expected %d\n",
+              point.x(), point.y(), distance, (long long)points.size(), vector, scalar, expected);
+      return false;
+    }
+    compared++;
+  }
+
+  fprintf(stdout, "[INFO] Hit test: The vector and the scalar versions agree in %d cases\n", compared);
+  return true;
+}
+
+int runSelfTests()
+{
+  QRandomGenerator rng(SELF_TEST_SEED);
+
+  const int checks = 4;
+  int failed = 0;
+  if (!checkPngEncoder(&rng))  failed++;
+  if (!checkQoiCodec(&rng))    failed++;
+  if (!checkProjectFile(&rng)) failed++;
+  if (!checkHitTest(&rng))     failed++;
+
+  if (failed > 0) {
+    fprintf(stderr, "[ERROR] %d of the %d checks failed\n", failed, checks);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stdout, "[INFO] All the checks passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,16 @@
+#ifndef SELFTEST_HPP
+#define SELFTEST_HPP
+
+// Checks of the encoders and of the algorithms that have to give the same
+// result in two different ways (--self-test). They don't need a display or any
+// file, so they can run in CI (ctest runs them):
+//  - The PNG encoder (in one piece and band by band) decodes to the same pixels
+//  - QOI encodes and decodes without losses
+//  - A project saved and read back has the same forms, and the broken files are
+//    reported with their own error
+//  - The hit test with SSE2/NEON gives the same result as the scalar one
+
+// Prints the result of each check. Returns the exit status of the program
+int runSelfTests();
+
+#endif // SELFTEST_HPP
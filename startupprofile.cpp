@@ -0,0 +1,53 @@
+#include "startupprofile.hpp"
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QCoreApplication>
+#include <atomic>
+#include <stdio.h>
+
+static QElapsedTimer profileTimer;
+static std::atomic<bool> profileFinished(false);
+
+void enableStartupProfile()
+{
+  profileTimer.start();
+}
+
+bool isStartupProfileEnabled()
+{
+  return profileTimer.isValid();
+}
+
+qint64 profileNow()
+{
+  return (isStartupProfileEnabled()) ? profileTimer.nsecsElapsed() : 0;
+}
+
+void profilePhase(const char *phase, const qint64 start)
+{
+  if (!isStartupProfileEnabled()) {
+    return;
+  }
+
+  const qint64 end = profileNow();
+  const bool mainThread = (QCoreApplication::instance() == nullptr)
+                          || (QThread::currentThread() == QCoreApplication::instance()->thread());
+
+  fprintf(stdout, "[PROFILE] %-24s %8.2f ms  (%8.2f -> %8.2f ms) %s\n",
+          phase,
+          (end - start) / 1e6,
+          start / 1e6,
+          end / 1e6,
+          (mainThread) ? "" : "[worker thread]");
+}
+
+void finishStartupProfile()
+{
+  if (!isStartupProfileEnabled() || profileFinished.exchange(true)) {
+    return;
+  }
+
+  fprintf(stdout, "[PROFILE] First frame painted after %.2f ms\n", profileNow() / 1e6);
+  fflush(stdout);
+}
@@ -0,0 +1,24 @@
+#ifndef STARTUPPROFILE_HPP
+#define STARTUPPROFILE_HPP
+
+#include <QtGlobal>
+
+// Timings of the startup (--startup-profile). Each phase prints when it started
+// and how long it took, relative to the start of the program, so the phases
+// that run at the same time (in other threads) can be told apart. Everything
+// is a no-op if the profile is not enabled
+
+// Starts the clock. It should be called as soon as possible in main()
+void enableStartupProfile();
+bool isStartupProfileEnabled();
+
+// Nanoseconds since the start of the program (0 if it's not enabled)
+qint64 profileNow();
+// Prints the phase that started at 'start' (from profileNow()) and ends now.
+// It can be called from any thread
+void profilePhase(const char *phase, const qint64 start);
+// Prints the time until the first frame (what the user waits for). Only the
+// first call prints something
+void finishStartupProfile();
+
+#endif // STARTUPPROFILE_HPP
@@ -0,0 +1,46 @@
+#include "strokefilter.hpp"
+
+#include <QLineF>
+#include <cmath>
+
+// Weight of the new value for a low-pass filter with this cutoff, after this
+// time since the previous value
+static qreal smoothingFactor(const qreal cutoff, const qreal seconds)
+{
+  const qreal timeConstant = 1.0 / (2.0 * M_PI * cutoff);
+  return 1.0 / (1.0 + timeConstant / seconds);
+}
+
+StrokeFilter::StrokeFilter(const qreal minCutoff, const qreal beta, const qreal speedCutoff)
+  : _minCutoff(minCutoff), _beta(beta), _speedCutoff(speedCutoff), _screenScale(1.0), _time(0)
+{
+}
+
+void StrokeFilter::reset(const QPointF point, const qint64 time, const qreal screenScale)
+{
+  _screenScale = screenScale;
+  _point = point;
+  _speed = QPointF(0, 0);
+  _time = time;
+}
+
+QPointF StrokeFilter::filter(const QPointF point, const qint64 time)
+{
+  // Without the compression of the events, some of them arrive in the same
+  // millisecond
+  const qreal seconds = qMax<qint64>(1, time - _time) / 1000.0;
+  _time = time;
+
+  const QPointF speed = (point - _point) / seconds;
+  _speed += (speed - _speed) * smoothingFactor(_speedCutoff, seconds);
+
+  const qreal cutoff = _minCutoff + _beta * speed();
+  _point += (point - _point) * smoothingFactor(cutoff, seconds);
+
+  return _point;
+}
+
+qreal StrokeFilter::speed() const
+{
+  return QLineF(QPointF(0, 0), _speed).length() * _screenScale;
+}
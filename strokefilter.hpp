@@ -0,0 +1,44 @@
+#ifndef STROKEFILTER_HPP
+#define STROKEFILTER_HPP
+
+#include <QPointF>
+#include <QtGlobal>
+
+// Smooths the points of a free form as they arrive, with the "One Euro" filter
+// (https://gery.casiez.net/1euro). It's a low-pass filter whose cutoff rises
+// with the speed of the pointer: the slow movements are smoothed a lot (the
+// jitter of the hand), and the fast ones barely (so the stroke doesn't lag
+// behind the cursor). Each point costs the same, so what's seen while drawing
+// is what's saved when releasing the mouse. Its parameters are in the
+// customization of zoomwidget.hpp (STROKE_FILTER_*)
+
+class StrokeFilter
+{
+  public:
+    // The cutoffs are in Hz, and beta in Hz per (pixel of the screen/sec)
+    StrokeFilter(const qreal minCutoff, const qreal beta, const qreal speedCutoff);
+
+    // Starts a new stroke at the point (which isn't smoothed). The points can
+    // be in any coordinates (like the ones of the pixmap), but the speed is
+    // measured in the screen, so the same movement of the hand is smoothed the
+    // same at any zoom. screenScale is the size in the screen of one unit of
+    // the points
+    void reset(const QPointF point, const qint64 time, const qreal screenScale);
+    // Returns the smoothed position of the next point of the stroke. The time
+    // is in msec, and it's the time of the event of the pointer
+    QPointF filter(const QPointF point, const qint64 time);
+    // Smoothed speed of the pointer at the last point (pixels of the screen
+    // per second)
+    qreal speed() const;
+
+  private:
+    qreal _minCutoff;
+    qreal _beta;
+    qreal _speedCutoff;
+    qreal _screenScale;
+    QPointF _point;
+    QPointF _speed; // Units of the points per second
+    qint64 _time;
+};
+
+#endif // STROKEFILTER_HPP
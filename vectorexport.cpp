@@ -0,0 +1,295 @@
+#include "vectorexport.hpp"
+#include "renderer.hpp"
+#include "pngencoder.hpp"
+
+#include <QTextStream>
+#include <QTextLayout>
+#include <QFontMetricsF>
+#include <QPdfWriter>
+#include <QPageSize>
+#include <QPainter>
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QPolygon>
+
+// The fonts of the pixmap are measured with this resolution, so the PDF and the
+// SVG use it too (otherwise, the texts would have a different size)
+#define SCREEN_DPI 96
+
+bool isVectorFormat(const QString extension)
+{
+  return extension.toLower() == "svg" || extension.toLower() == "pdf";
+}
+
+static const char *svgLineCap(const Qt::PenCapStyle cap)
+{
+  switch (cap) {
+    case Qt::FlatCap:  return "butt";
+    case Qt::RoundCap: return "round";
+    default:           return "square";
+  }
+}
+
+static const char *svgLineJoin(const Qt::PenJoinStyle join)
+{
+  switch (join) {
+    case Qt::MiterJoin: return "miter";
+    case Qt::RoundJoin: return "round";
+    default:            return "bevel";
+  }
+}
+
+// Attributes of the outline of a form (like the pen of the painter)
+static QString svgStroke(const QPen &pen, const int width, const int alpha)
+{
+  return QString("stroke=\"%1\" stroke-opacity=\"%2\" stroke-width=\"%3\" stroke-linecap=\"%4\" stroke-linejoin=\"%5\"")
+           .arg(pen.color().name(QColor::HexRgb))
+           .arg(alpha / 255.0)
+           .arg(qMax(1, width))
+           .arg(svgLineCap(pen.capStyle()))
+           .arg(svgLineJoin(pen.joinStyle()));
+}
+
+// Attributes of the semi-transparent background of the highlighted forms
+static QString svgHighlight(const QPen &pen)
+{
+  return QString("fill=\"%1\" fill-opacity=\"%2\" stroke=\"none\"")
+           .arg(pen.color().name(QColor::HexRgb))
+           .arg(HIGHLIGHT_ALPHA / 255.0);
+}
+
+static void writeSvgLine(QTextStream &out, const QPoint p1, const QPoint p2, const QString &stroke)
+{
+  out << "<line x1=\"" << p1.x() << "\" y1=\"" << p1.y()
+      << "\" x2=\"" << p2.x() << "\" y2=\"" << p2.y() << "\" " << stroke << "/>\n";
+}
+
+static void writeSvgArrowHead(QTextStream &out, const ArrowHead &head, const QString &stroke)
+{
+  writeSvgLine(out, head.startPoint, head.rightLineEnd, stroke);
+  writeSvgLine(out, head.startPoint, head.leftLineEnd, stroke);
+}
+
+static void writeSvgRoundedRect(QTextStream &out, const QRect rect, const QString &attributes)
+{
+  out << "<rect x=\"" << rect.x() << "\" y=\"" << rect.y()
+      << "\" width=\"" << rect.width() << "\" height=\"" << rect.height()
+      << "\" rx=\"" << RECT_ROUNDNESS << "\" ry=\"" << RECT_ROUNDNESS << "\" " << attributes << "/>\n";
+}
+
+// SVG doesn't wrap the texts, so the lines are laid out like QPainter::drawText()
+// does with Qt::AlignCenter and Qt::TextWordWrap
+static void writeSvgText(QTextStream &out, const Form &f, const int x, const int y, const int w, const int h)
+{
+  const int penWidth = f.pen.width();
+  const QRect rect = fixQRect(x, y, w, h);
+
+  // Don't draw the text over the border (same as drawForm())
+  QRectF textRect(rect.x() + penWidth/2,
+                  rect.y() + penWidth/2,
+                  qMax(0, rect.width() - penWidth/2),
+                  qMax(0, rect.height() - penWidth/2));
+
+  QFont font;
+  font.setPixelSize(qMax(1, qRound(penWidth * FONT_SCALE * SCREEN_DPI / 72.0)));
+  const QFontMetricsF metrics(font);
+
+  QString text = f.text;
+  text.replace('\n', QChar::LineSeparator);
+
+  QTextOption option(Qt::AlignHCenter);
+  option.setWrapMode(QTextOption::WordWrap);
+  QTextLayout layout(text, font);
+  layout.setTextOption(option);
+
+  QList<QString> lines;
+  layout.beginLayout();
+  for (QTextLine line = layout.createLine(); line.isValid(); line = layout.createLine()) {
+    line.setLineWidth(textRect.width());
+    QString lineText = text.mid(line.textStart(), line.textLength());
+    lineText.remove(QChar::LineSeparator);
+    lines.append(lineText.trimmed());
+  }
+  layout.endLayout();
+
+  const qreal top = textRect.center().y() - (lines.size() * metrics.lineSpacing()) / 2.0;
+
+  out << "<text x=\"" << textRect.center().x() << "\" text-anchor=\"middle\""
+      << " font-family=\"" << font.family().toHtmlEscaped() << "\" font-size=\"" << font.pixelSize() << "\""
+      << " fill=\"" << f.pen.color().name(QColor::HexRgb) << "\" fill-opacity=\"" << f.pen.color().alphaF() << "\">\n";
+  for (int i=0; i<lines.size(); i++) {
+    out << "  <tspan x=\"" << textRect.center().x() << "\" y=\"" << (top + i * metrics.lineSpacing() + metrics.ascent())
+        << "\" xml:space=\"preserve\">" << lines.at(i).toHtmlEscaped() << "</tspan>\n";
+  }
+  out << "</text>\n";
+}
+
+static void writeSvgForm(QTextStream &out, const Form &f)
+{
+  if (f.deleted || f.active || f.points.isEmpty()) {
+    return;
+  }
+
+  const int alpha = f.pen.color().alpha();
+  const QString stroke = "fill=\"none\" " + svgStroke(f.pen, f.pen.width(), alpha);
+  QRect rect;
+  int x=0, y=0, w=0, h=0;
+  if (f.type != FREEFORM && f.points.size() >= 2) {
+    x = f.points.at(0).x();
+    y = f.points.at(0).y();
+    w = f.points.at(1).x() - x;
+    h = f.points.at(1).y() - y;
+    rect = fixQRect(x, y, w, h);
+  }
+
+  switch (f.type) {
+    case RECTANGLE:
+      if (f.highlight) writeSvgRoundedRect(out, rect, svgHighlight(f.pen));
+      writeSvgRoundedRect(out, rect, stroke);
+      break;
+
+    case LINE:
+      // A wider semi-transparent line behind the line as the highlight
+      if (f.highlight) {
+        writeSvgLine(out, QPoint(x, y), QPoint(x+w, y+h), "fill=\"none\" " + svgStroke(f.pen, f.pen.width() * 4, HIGHLIGHT_ALPHA));
+      }
+      if (f.arrow) writeSvgArrowHead(out, getArrowHead(x, y, w, h, 0), stroke);
+      writeSvgLine(out, QPoint(x, y), QPoint(x+w, y+h), stroke);
+      break;
+
+    case ELLIPSE: {
+      const QString ellipse = QString("<ellipse cx=\"%1\" cy=\"%2\" rx=\"%3\" ry=\"%4\" ")
+                                .arg(rect.x() + rect.width() / 2.0)
+                                .arg(rect.y() + rect.height() / 2.0)
+                                .arg(rect.width() / 2.0)
+                                .arg(rect.height() / 2.0);
+      if (f.highlight) out << ellipse << svgHighlight(f.pen) << "/>\n";
+      out << ellipse << stroke << "/>\n";
+      break;
+    }
+
+    case TEXT:
+      if (f.highlight) {
+        writeSvgRoundedRect(out, rect, svgHighlight(f.pen));
+        writeSvgRoundedRect(out, rect, stroke);
+      }
+      writeSvgText(out, f, x, y, w, h);
+      break;
+
+    case FREEFORM: {
+      if (f.highlight) {
+        // You can't draw a highlighted arrow in free form
+        out << "<polygon points=\"";
+        for (int i=0; i<f.points.size(); i++) {
+          out << f.points.at(i).x() << "," << f.points.at(i).y() << " ";
+        }
+        out << "\" fill=\"" << f.pen.color().name(QColor::HexRgb) << "\" fill-opacity=\"" << (HIGHLIGHT_ALPHA / 255.0)
+            << "\" " << svgStroke(f.pen, f.pen.width(), alpha) << "/>\n";
+        break;
+      }
+
+      // Each segment has its own width. The consecutive segments with the same
+      // width are joined into a single polyline, with round caps and joins like
+      // the outline of the pixmap (see freeFormOutline())
+      QPen roundPen = f.pen;
+      roundPen.setCapStyle(Qt::RoundCap);
+      roundPen.setJoinStyle(Qt::RoundJoin);
+      for (int start=0; start < f.points.size()-1; ) {
+        const int width = f.penWidths.at(start);
+        int end = start + 1;
+        while (end < f.points.size()-1 && f.penWidths.at(end) == width) end++;
+
+        out << "<polyline points=\"";
+        for (int i=start; i<=end; i++) {
+          out << f.points.at(i).x() << "," << f.points.at(i).y() << " ";
+        }
+        out << "\" fill=\"none\" " << svgStroke(roundPen, width, alpha) << "/>\n";
+
+        start = end;
+      }
+      if (f.arrow) writeSvgArrowHead(out, getFreeFormArrowHead(f), stroke);
+      break;
+    }
+  }
+}
+
+bool writeSvg(const Project &project, const QRect area, QIODevice *device)
+{
+  QTextStream out(device);
+
+  out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+      << " width=\"" << area.width() << "\" height=\"" << area.height() << "\""
+      << " viewBox=\"" << area.x() << " " << area.y() << " " << area.width() << " " << area.height() << "\">\n";
+
+  // The background is the only raster part (embedded as a PNG)
+  if (!project.source.isNull()) {
+    QByteArray png;
+    QBuffer buffer(&png); buffer.open(QIODevice::WriteOnly);
+    if (!writePng(project.source.copy(area), &buffer)) {
+      return false;
+    }
+
+    out << "<image x=\"" << area.x() << "\" y=\"" << area.y()
+        << "\" width=\"" << area.width() << "\" height=\"" << area.height()
+        << "\" xlink:href=\"data:image/png;base64,";
+    out.flush();
+    device->write(png.toBase64());
+    out << "\"/>\n";
+  }
+
+  for (int i=0; i<project.forms.size(); i++) {
+    writeSvgForm(out, project.forms.at(i));
+  }
+
+  out << "</svg>\n";
+  out.flush();
+
+  return out.status() == QTextStream::Ok;
+}
+
+bool writePdf(const Project &project, const QRect area, QIODevice *device)
+{
+  // One page with the size of the area (one pixel of the pixmap is a pixel of
+  // the screen in the PDF)
+  QPdfWriter writer(device);
+  writer.setCreator("ZoomMe");
+  writer.setResolution(SCREEN_DPI);
+  writer.setPageSize(QPageSize(QSizeF(area.size()) * 72.0 / SCREEN_DPI, QPageSize::Point, QString(), QPageSize::ExactMatch));
+  writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+
+  // QPdfWriter keeps the drawings as vectors
+  QPainter painter;
+  if (!painter.begin(&writer)) {
+    return false;
+  }
+
+  painter.translate(-area.topLeft());
+  painter.setClipRect(area);
+  if (!project.source.isNull()) {
+    painter.drawImage(area.topLeft(), project.source, area);
+  }
+  for (int i=0; i<project.forms.size(); i++) {
+    drawForm(&painter, project.forms.at(i), false);
+  }
+
+  return painter.end();
+}
+
+bool writeVectorImage(const Project &project, const QRect area, const QString path)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  const bool success = (QFileInfo(path).suffix().toLower() == "pdf")
+                       ? writePdf(project, area, &file)
+                       : writeSvg(project, area, &file);
+  if (!success) {
+    file.remove();
+  }
+
+  return success;
+}
@@ -0,0 +1,26 @@
+#ifndef VECTOREXPORT_HPP
+#define VECTOREXPORT_HPP
+
+#include "project.hpp"
+#include <QRect>
+#include <QString>
+#include <QIODevice>
+
+// Exports the drawings as vectors (over the background, which is embedded as
+// an image), so they can be scaled without losing quality. The forms are
+// written one by one into the device, so the memory used doesn't depend on the
+// number of forms
+
+// Returns true if the extension is one of the vector formats ("svg" or "pdf")
+bool isVectorFormat(const QString extension);
+
+// The area is in pixmap coordinates. If the source of the project is null, the
+// background is not exported (for example, in live mode)
+bool writeSvg(const Project &project, const QRect area, QIODevice *device);
+bool writePdf(const Project &project, const QRect area, QIODevice *device);
+
+// Writes the SVG or the PDF in the path, depending on its extension. Returns
+// false if it couldn't be written
+bool writeVectorImage(const Project &project, const QRect area, const QString path);
+
+#endif // VECTOREXPORT_HPP
@@ -0,0 +1,196 @@
+#include "x11capture.hpp"
+
+#ifdef ZOOMME_XCOMPOSITE
+#include <QGuiApplication>
+#include <QPainter>
+#include <QSysInfo>
+// After the Qt headers (Xlib defines macros like None, Bool or Status)
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/Xcomposite.h>
+
+// The windows can be closed while they're being captured, so their errors are
+// ignored (the default handler exits)
+static int ignoreXError(Display *, XErrorEvent *)
+{
+  return 0;
+}
+
+static Display* x11Display()
+{
+  if (QGuiApplication::platformName() != QString("xcb")) {
+    return nullptr;
+  }
+
+  auto *x11 = qGuiApp->nativeInterface<QNativeInterface::QX11Application>();
+  return (x11) ? x11->display() : nullptr;
+}
+
+// Whether the X server has the version 0.2 of the extension (the pixmaps of
+// the windows need it). -1 until it's checked
+static int compositeAvailable = -1;
+// The windows are only redirected while the live zoom captures them, because
+// without a compositor it keeps a pixmap of every window
+static bool redirected = false;
+
+// The windows are redirected automatically (so the X server keeps drawing the
+// screen like before)
+static bool redirectWindows(Display *display)
+{
+  if (compositeAvailable == -1) {
+    int eventBase, errorBase, major = 0, minor = 2;
+    compositeAvailable = XCompositeQueryExtension(display, &eventBase, &errorBase) &&
+                         XCompositeQueryVersion(display, &major, &minor) &&
+                         (major > 0 || minor >= 2);
+  }
+
+  if (compositeAvailable == 1 && !redirected) {
+    XCompositeRedirectSubwindows(display, DefaultRootWindow(display), CompositeRedirectAutomatic);
+    redirected = true;
+  }
+  return compositeAvailable == 1;
+}
+
+// The top-level window of the widget is a child of the root window, or a child
+// of the frame that the window manager puts around it
+static Window topLevelWindow(Display *display, Window window)
+{
+  const Window root = DefaultRootWindow(display);
+  Window rootReturn, parent;
+  Window *children;
+  unsigned int count;
+  while (XQueryTree(display, window, &rootReturn, &parent, &children, &count)) {
+    if (children) XFree(children);
+    if (parent == root || parent == 0) break;
+    window = parent;
+  }
+  return window;
+}
+
+// Draws the part of the drawable (at drawableRect, in the coordinates of the
+// root window) that is inside the region. Only the usual format is supported
+// (32 bits per pixel, with the order of the bytes of QImage)
+static void drawDrawable(QPainter *painter, Display *display, const Drawable drawable, const QRect drawableRect, const QRect region, const bool hasAlpha)
+{
+  const QRect visible = drawableRect.intersected(region);
+  if (visible.isEmpty()) {
+    return;
+  }
+
+  XImage *ximage = XGetImage(display, drawable, visible.x() - drawableRect.x(), visible.y() - drawableRect.y(),
+                             visible.width(), visible.height(), AllPlanes, ZPixmap);
+  if (!ximage) {
+    return;
+  }
+
+  const int byteOrder = (QSysInfo::ByteOrder == QSysInfo::LittleEndian) ? LSBFirst : MSBFirst;
+  if (ximage->bits_per_pixel == 32 && ximage->byte_order == byteOrder &&
+      ximage->red_mask == 0xff0000 && ximage->green_mask == 0xff00 && ximage->blue_mask == 0xff) {
+    // The windows with alpha (depth 32) are premultiplied, like the compositors
+    // expect them
+    const QImage image((const uchar*) ximage->data, ximage->width, ximage->height, ximage->bytes_per_line,
+                       (hasAlpha) ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    painter->drawImage(visible.topLeft() - region.topLeft(), image);
+  }
+  XDestroyImage(ximage);
+}
+#endif
+
+QImage grabScreenUnderWindow(const QScreen *screen, const QWidget *widget, const QRect region)
+{
+#ifdef ZOOMME_XCOMPOSITE
+  Display *display = x11Display();
+  if (!display || !redirectWindows(display)) {
+    return QImage();
+  }
+
+  const Window root = DefaultRootWindow(display);
+  const Window own = topLevelWindow(display, (Window) widget->window()->winId());
+  // The coordinates of the root window are in pixels of the screens
+  const QRect rootRegion = region.translated(screen->geometry().topLeft() * screen->devicePixelRatio());
+
+  XErrorHandler previousHandler = XSetErrorHandler(ignoreXError);
+
+  QImage capture(rootRegion.size(), QImage::Format_RGB32);
+  capture.fill(Qt::black);
+  QPainter painter(&capture);
+
+  // The wallpaper (most of the desktops set this property of the root window,
+  // and the others draw it in a window)
+  const Atom wallpaperAtom = XInternAtom(display, "_XROOTPMAP_ID", True);
+  if (wallpaperAtom != None) {
+    Atom type;
+    int format;
+    unsigned long items, remaining;
+    unsigned char *data = nullptr;
+    if (XGetWindowProperty(display, root, wallpaperAtom, 0, 1, False, XA_PIXMAP,
+                           &type, &format, &items, &remaining, &data) == Success && data) {
+      if (type == XA_PIXMAP && items == 1) {
+        const Pixmap wallpaper = *(Pixmap*) data;
+        Window rootReturn;
+        int x, y;
+        unsigned int w, h, border, depth;
+        if (XGetGeometry(display, wallpaper, &rootReturn, &x, &y, &w, &h, &border, &depth)) {
+          drawDrawable(&painter, display, wallpaper, QRect(0, 0, w, h), rootRegion, false);
+        }
+      }
+      XFree(data);
+    }
+  }
+
+  // The children of the root window are in stacking order (from the bottom to
+  // the top), so they're drawn like the screen shows them
+  Window rootReturn, parent;
+  Window *children;
+  unsigned int count;
+  if (XQueryTree(display, root, &rootReturn, &parent, &children, &count)) {
+    for (unsigned int i=0; i<count; i++) {
+      XWindowAttributes attributes;
+      if (children[i] == own ||
+          !XGetWindowAttributes(display, children[i], &attributes) ||
+          attributes.map_state != IsViewable || attributes.c_class == InputOnly) {
+        continue;
+      }
+
+      // The position is the one of the border, and the pixmap has the border
+      const int border = attributes.border_width;
+      const QRect windowRect(attributes.x, attributes.y, attributes.width + 2*border, attributes.height + 2*border);
+      if (!windowRect.intersects(rootRegion)) {
+        continue;
+      }
+
+      const Pixmap contents = XCompositeNameWindowPixmap(display, children[i]);
+      drawDrawable(&painter, display, contents, windowRect, rootRegion, attributes.depth == 32);
+      XFreePixmap(display, contents);
+    }
+    if (children) XFree(children);
+  }
+  painter.end();
+
+  // The errors arrive before restoring the handler
+  XSync(display, False);
+  XSetErrorHandler(previousHandler);
+
+  return capture;
+#else
+  Q_UNUSED(screen);
+  Q_UNUSED(widget);
+  Q_UNUSED(region);
+  return QImage();
+#endif
+}
+
+void stopScreenCapture()
+{
+#ifdef ZOOMME_XCOMPOSITE
+  Display *display = x11Display();
+  if (!display || !redirected) {
+    return;
+  }
+
+  XCompositeUnredirectSubwindows(display, DefaultRootWindow(display), CompositeRedirectAutomatic);
+  XFlush(display);
+  redirected = false;
+#endif
+}
@@ -0,0 +1,25 @@
+#ifndef X11CAPTURE_HPP
+#define X11CAPTURE_HPP
+
+#include <QImage>
+#include <QRect>
+#include <QScreen>
+#include <QWidget>
+
+// The zoom of the live mode captures the desktop under the window again and
+// again, so the window can't be hidden for each capture (it blinks, and there's
+// no promise of when the compositor removes it from the screen). In X11 with
+// the Composite extension, every window keeps its contents in its own pixmap,
+// so the region is built from the windows under ZoomMe, without hiding it
+
+// Captures the region (in pixels of the screen, not fixed to HDPI scaling) of
+// the desktop without the window of the widget. Returns a null image if it
+// isn't supported (it isn't X11 or it was compiled without Xcomposite), so the
+// window has to be hidden to grab the screen
+QImage grabScreenUnderWindow(const QScreen *screen, const QWidget *widget, const QRect region);
+// The first capture redirects all the windows to their own pixmaps (without a
+// compositor, the X server keeps them only for this), so it should be called
+// when the captures stop. The next capture redirects them again
+void stopScreenCapture();
+
+#endif
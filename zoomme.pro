@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui opengl widgets openglwidgets
+QT       += core gui opengl widgets openglwidgets concurrent network
 
 TARGET = zoomme
 TEMPLATE = app
@@ -13,8 +13,45 @@ TEMPLATE = app
 RESOURCES += resources.qrc
 
 SOURCES += main.cpp\
-        zoomwidget.cpp
+        zoomwidget.cpp\
+        project.cpp\
+        renderer.cpp\
+        exporter.cpp\
+        pngencoder.cpp\
+        qoi.cpp\
+        vectorexport.cpp\
+        startupprofile.cpp\
+        daemon.cpp\
+        iconatlas.cpp\
+        imagedetail.cpp\
+        strokefilter.cpp\
+        x11capture.cpp\
+        selftest.cpp
 
-HEADERS  += zoomwidget.hpp
+HEADERS  += zoomwidget.hpp\
+        project.hpp\
+        renderer.hpp\
+        exporter.hpp\
+        pngencoder.hpp\
+        qoi.hpp\
+        vectorexport.hpp\
+        startupprofile.hpp\
+        daemon.hpp\
+        iconatlas.hpp\
+        imagedetail.hpp\
+        strokefilter.hpp\
+        x11capture.hpp\
+        selftest.hpp
 
 FORMS    += zoomwidget.ui
+
+# Used by the parallel PNG encoder
+LIBS     += -lz
+
+# Optional: the zoom of the live mode captures the desktop without hiding the
+# window in X11 (see x11capture.hpp)
+unix:!macx:packagesExist(x11 xcomposite) {
+    DEFINES   += ZOOMME_XCOMPOSITE
+    CONFIG    += link_pkgconfig
+    PKGCONFIG += x11 xcomposite
+}
@@ -1,10 +1,17 @@
 #include "zoomwidget.hpp"
 #include "ui_zoomwidget.h"
+#include "renderer.hpp"
+#include "project.hpp"
+#include "qoi.hpp"
+#include "vectorexport.hpp"
+#include "startupprofile.hpp"
+#include "x11capture.hpp"
 
 #include <cmath>
 #include <cstdio>
 #include <QPainter>
 #include <QMouseEvent>
+#include <QTabletEvent>
 #include <QRect>
 #include <QGuiApplication>
 #include <QOpenGLWidget>
@@ -13,16 +20,29 @@
 #include <QColor>
 #include <QPainterPath>
 #include <QList>
-#include <QImageWriter>
 #include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
 #include <QMimeData>
-#include <QUrl>
 #include <QFontMetrics>
 #include <QFontDatabase>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QFutureWatcher>
+#include <QRegion>
+#include <QLoggingCategory>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#ifndef WDA_EXCLUDEFROMCAPTURE
+#define WDA_EXCLUDEFROMCAPTURE 0x00000011
+#endif
+#endif
 
-ZoomWidget::ZoomWidget(QWidget *parent) : QWidget(parent), ui(new Ui::zoomwidget)
+// Statistics of the free forms, for debugging. They're disabled by default
+// (enable them with QT_LOGGING_RULES="zoomme.stroke.debug=true")
+Q_LOGGING_CATEGORY(strokeLog, "zoomme.stroke", QtInfoMsg)
+
+ZoomWidget::ZoomWidget(QWidget *parent) : QWidget(parent), ui(new Ui::zoomwidget),
+  _strokeFilter(STROKE_FILTER_MIN_CUTOFF, STROKE_FILTER_BETA, STROKE_FILTER_SPEED_CUTOFF)
 {
   ui->setupUi(this);
   setMouseTracking(true);
@@ -34,12 +54,16 @@ ZoomWidget::ZoomWidget(QWidget *parent) : QWidget(parent), ui(new Ui::zoomwidget
   setPalette(QCOLOR_BACKGROUND);
   setAutoFillBackground(true);
 
-  // Fonts
-  QFontDatabase::addApplicationFont(":/resources/Hack Nerd Font/HackNerdFont-Regular.ttf");
-  QFontDatabase::addApplicationFont(":/resources/Hack Nerd Font/HackNerdFont-Bold.ttf");
-  QFontDatabase::addApplicationFont(":/resources/Hack Nerd Font/HackNerdFont-Italic.ttf");
-  QFontDatabase::addApplicationFont(":/resources/Hack Nerd Font/HackNerdFont-BoldItalic.ttf");
-  setFont(QFont("Hack Nerd Font", 4*FONT_SCALE));
+  // Fonts. They're registered by the thread pool while the desktop (or the
+  // image) is being grabbed, and they're applied before the first frame (see
+  // applyFonts())
+  _fontsLoading = QtConcurrent::run([]() {
+    const qint64 start = profileNow();
+    // Only the styles that are used (the titles of the pop-ups are bold)
+    QFontDatabase::addApplicationFont(":/resources/Hack Nerd Font/HackNerdFont-Regular.ttf");
+    QFontDatabase::addApplicationFont(":/resources/Hack Nerd Font/HackNerdFont-Bold.ttf");
+    profilePhase("Font registration", start);
+  });
 
   _desktopScreen         = QGuiApplication::screenAt(QCursor::pos());
   _windowSize            = _desktopScreen->geometry().size();
@@ -49,6 +73,7 @@ ZoomWidget::ZoomWidget(QWidget *parent) : QWidget(parent), ui(new Ui::zoomwidget
   _canvas.scale          = 1.0f;
   _canvas.freezePos      = FREEZE_FALSE;
   _canvas.dragging       = false;
+  _view.scale            = 0.0f; // Not computed yet
 
   _state                 = STATE_NORMAL;
   _drawMode              = LINE;
@@ -64,16 +89,36 @@ ZoomWidget::ZoomWidget(QWidget *parent) : QWidget(parent), ui(new Ui::zoomwidget
   _flashlightRadius      = 80;
   _popupTray.margin      = 20;
   _toolBar.show          = false;
+  _firstFramePainted     = false;
+  _loadingClipboard      = false;
+  _fileConfig.toStdout   = false;
 
   _lastMousePos          = GET_CURSOR_POS();
+  _tabletStroke          = false;
+  _strokeMoveQueued      = false;
   _clipboard             = QApplication::clipboard();
 
+  // The cursor of the color picker is loaded once (the shape of the cursor is
+  // updated on every movement of the mouse)
+  QPixmap pickColorPixmap(":/resources/color-picker/16.png");
+  if (pickColorPixmap.isNull()) {
+    logUser(LOG_ERROR, "", "Failed to load pixmap for the color-picker cursor");
+  }
+  _pickColorCursor = QCursor(pickColorPixmap, 0, pickColorPixmap.height()-1);
+
   _recordTimer           = new QTimer(this);
   _popupTray.updateTimer = new QTimer(this);
   _exitTimer             = new QTimer(this);
+  _liveZoomTimer         = new QTimer(this);
+  _liveZoomLastMove      = 0;
+  _liveZoomCapturing     = false;
+  _liveZoomHidesWindow   = false;
   connect(_recordTimer, &QTimer::timeout, this, &ZoomWidget::saveFrameToFile);
+  _liveZoomTimer->setSingleShot(true);
+  connect(_liveZoomTimer, &QTimer::timeout, this, &ZoomWidget::captureLiveZoom);
   connect(_popupTray.updateTimer, &QTimer::timeout, this, &ZoomWidget::updateForPopups);
   connect(_exitTimer, &QTimer::timeout, this, [=]() { toggleAction(ACTION_ESCAPE_CANCEL); });
+  connect(&_imageDetail, &ImageDetail::tileDecoded, this, QOverload<>::of(&ZoomWidget::update));
 
   QDir tempFolder(QStandardPaths::writableLocation(QStandardPaths::TempLocation));
   _recordTempFile = new QFile(tempFolder.absoluteFilePath(RECORD_TEMP_FILENAME));
@@ -84,17 +129,56 @@ ZoomWidget::ZoomWidget(QWidget *parent) : QWidget(parent), ui(new Ui::zoomwidget
   // ffmpeg.setStandardErrorFile("ffmpeg_log.txt");
   // ffmpeg.setStandardOutputFile("ffmpeg_output.txt");
 
+  _exporter = new ImageExporter;
+  _exporter->moveToThread(&_exportThread);
+  connect(&_exportThread, &QThread::finished, _exporter, &QObject::deleteLater);
+  connect(_exporter, &ImageExporter::imageSaved, this, &ZoomWidget::imageExported, Qt::QueuedConnection);
+  connect(_exporter, &ImageExporter::imageEncoded, this, &ZoomWidget::pipeToClipboard, Qt::QueuedConnection);
+  _exportThread.start();
+
   if (!_clipboard) {
     logUser(LOG_ERROR, "", "Couldn't grab the clipboard");
   }
 
   setPopupTrayPos();
   loadButtons();
+  // The tool bar is generated when the fonts are applied (it depends on them)
+}
+
+void ZoomWidget::applyFonts()
+{
+  if (!_fontsLoading.isValid()) {
+    return; // Already applied
+  }
+
+  const qint64 start = profileNow();
+  _fontsLoading.waitForFinished();
+  _fontsLoading = QFuture<void>();
+
+  setFont(QFont("Hack Nerd Font", 4*FONT_SCALE));
   generateToolBar();
+
+  // Rasterize the icons of the tool bar now, so the first frame only blits them
+  QList<QString> icons;
+  for (int i=0; i<_toolBar.buttons.size(); i++) {
+    icons.append(_toolBar.buttons.at(i).icon);
+  }
+  _iconAtlas.setFont(font());
+  _iconAtlas.addIcons(icons);
+  profilePhase("Apply fonts", start);
 }
 
 ZoomWidget::~ZoomWidget()
 {
+  // Wait for the images that are still being saved
+  _exportThread.quit();
+  _exportThread.wait();
+
+  // If it's closed while drawing a free form (the daemon keeps the application)
+  setPointerEventsCompressed(true);
+  // If it's closed while zooming in live mode
+  stopScreenCapture();
+
   delete ui;
 }
 
@@ -255,11 +339,11 @@ void ZoomWidget::toggleAction(const Action action)
        break;
 
     case ACTION_SAVE_TO_FILE:
-       saveImage(_canvas.pixmap, true);
+       saveImage(_canvas.pixmap.rect(), true);
        break;
 
     case ACTION_SAVE_TO_CLIPBOARD:
-       saveImage(_canvas.pixmap, false);
+       saveImage(_canvas.pixmap.rect(), false);
        break;
 
     case ACTION_SAVE_TRIMMED_TO_IMAGE:
@@ -324,7 +408,7 @@ void ZoomWidget::toggleAction(const Action action)
     case ACTION_ESCAPE:
       if (_exitTimer->isActive()) {
         QApplication::beep();
-        QApplication::quit();
+        emit quitRequested();
         break;
       }
 
@@ -353,6 +437,7 @@ void ZoomWidget::toggleAction(const Action action)
         _canvas.scale = 1.0f;
         scalePixmapAt(QPoint(0,0));
         _canvas.pos = centerCanvas();
+        if (_liveMode) updateLiveZoom();
 
       } else if (isDisabledMouseTracking() && _canvas.pos != centerCanvas()) {
         _canvas.pos = centerCanvas();
@@ -379,20 +464,6 @@ void ZoomWidget::toggleAction(const Action action)
   update();
 }
 
-Form ZoomWidget::smoothFreeForm(Form form)
-{
-  // Iterate over the points, and make the average between the previous and the
-  // next point
-  for (int i=1; i<form.points.size()-1; i++) {
-    const QPoint start = form.points.at(i-1);
-    const QPoint end   = form.points.at(i+1);
-
-    form.points.replace(i, (start + end) / 2);
-  }
-
-  return form;
-}
-
 void ZoomWidget::loadButtons()
 {
   _toolBar.buttons.clear();
@@ -466,6 +537,12 @@ void ZoomWidget::loadButtons()
 
 bool ZoomWidget::isActionActive(const Action action)
 {
+  // Until the image of the clipboard arrives, the placeholder can only be
+  // closed (the drawings and exports would be of the placeholder)
+  if (_loadingClipboard && action != ACTION_ESCAPE && action != ACTION_ESCAPE_CANCEL) {
+    return false;
+  }
+
   switch (action) {
     case ACTION_WIDTH_1:
     case ACTION_WIDTH_2:
@@ -835,36 +912,6 @@ bool ZoomWidget::isCursorOverButton(const QPoint cursorPos)
   return isOverAButton && isNotASpacer;
 }
 
-void sendForm(QDataStream *out, Form data)
-{
-  *out << data.type
-       << data.points
-       << data.pen
-       << data.highlight
-       << data.arrow
-       << data.deleted
-       << data.penWidths
-       << data.active
-       << data.caretPos
-       << data.text;
-}
-
-Form receiveForm(QDataStream *in)
-{
-  Form data;
-  *in >> data.type
-      >> data.points
-      >> data.pen
-      >> data.highlight
-      >> data.arrow
-      >> data.deleted
-      >> data.penWidths
-      >> data.active
-      >> data.caretPos
-      >> data.text;
-  return data;
-}
-
 void ZoomWidget::saveStateToFile()
 {
   QString filePath = getFilePath(FILE_ZOOMME);
@@ -874,78 +921,75 @@ void ZoomWidget::saveStateToFile()
     return;
   }
 
+  Project project;
+  project.windowSize     = _windowSize;
+  project.source         = (_screenTiles.isEmpty()) ? _canvas.source.toImage() : getScreenTilesImage();
+  project.originalSize   = _canvas.originalSize;
+  project.name           = _fileConfig.name;
+  project.imageExt       = _fileConfig.imageExt;
+  project.videoExt       = _fileConfig.videoExt;
+  project.zoommeExt      = _fileConfig.zoommeExt;
+  project.liveMode       = _liveMode;
+  project.drawMode       = _drawMode;
+  project.activePen      = _activePen;
+  project.highlight      = _highlight;
+  project.deletedHistory = _deletedHistory;
+  project.forms          = _forms;
+  project.thumbnail      = renderThumbnail(project);
+
   QDataStream out(&file);
-  // There should be the same arguments that the restoreStateToFile()
-  out << _windowSize
-      << _canvas.source
-      << _canvas.originalSize
-
-      << _fileConfig.name
-      << _fileConfig.imageExt
-      << _fileConfig.videoExt
-      << _fileConfig.zoommeExt
-      << _liveMode
-      << _drawMode
-      << _activePen
-      << _highlight
-
-      << _deletedHistory
-      << _forms.size();
-
-  // Save the drawings
-  for (int i=0; i<_forms.size(); i++) {
-    sendForm(&out, _forms.at(i));
-  }
+  writeProject(&out, project);
 
   QApplication::beep();
   logUser(LOG_SUCCESS, "Project file saved correctly!", "Project saved correctly: %s", QSTRING_TO_STRING(filePath));
 }
 
-void ZoomWidget::restoreStateFromFile(const QString path)
+bool ZoomWidget::restoreStateFromFile(const QString path)
 {
   QFile file(path);
   if (!file.open(QIODevice::ReadOnly)) {
-    logUser(LOG_ERROR_AND_EXIT, "", "Couldn't restore the state from the file");
+    logUser(LOG_TEXT, "", "Couldn't open the file to restore the state");
+    return false;
   }
 
-  long long formListSize = 0;
-
-  QPixmap savedPixmap;
-  QSize savedPixmapSize;
-
-  // There should be the same arguments that the saveStateToFile()
+  Project project;
   QDataStream in(&file);
-  in  >> _windowSize
-      >> savedPixmap
-      >> savedPixmapSize
-
-      >> _fileConfig.name
-      >> _fileConfig.imageExt
-      >> _fileConfig.videoExt
-      >> _fileConfig.zoommeExt
-      >> _liveMode
-      >> _drawMode
-      >> _activePen
-      >> _highlight
-
-      >> _deletedHistory
-      >> formListSize;
+  const ProjectReadStatus status = readProject(&in, &project);
+  if (status == PROJECT_READ_DATA_LEFT) {
+    logUser(LOG_TEXT, "", "There is data left in the ZoomMe file that was not loaded by the recovery algorithm (because it ended before the EOF). Please check the saving and the recovery algorithm: There may be some variables missing in the recovery and not in the saving or some variables added in the saving but not in the recovery...");
+    return false;
+  }
+  if (status != PROJECT_READ_OK) {
+    logUser(LOG_ERROR, "", "Couldn't restore the state. %s: %s", projectReadError(status), QSTRING_TO_STRING(path));
+    return false;
+  }
+
+  _windowSize           = project.windowSize;
+  _fileConfig.name      = project.name;
+  _fileConfig.imageExt  = project.imageExt;
+  _fileConfig.videoExt  = project.videoExt;
+  _fileConfig.zoommeExt = project.zoommeExt;
+  _liveMode             = project.liveMode;
+  _drawMode             = project.drawMode;
+  _activePen            = project.activePen;
+  _highlight            = project.highlight;
+  _deletedHistory       = project.deletedHistory;
+  _forms                = project.forms;
+  for (int i=0; i<_forms.size(); i++) {
+    if (_forms.at(i).type == FREEFORM && !_forms.at(i).highlight) {
+      _forms[i].outline = freeFormOutline(_forms.at(i));
+    }
+  }
 
   resize(_windowSize);
-  _canvas.source = savedPixmap;
-  _canvas.size = savedPixmapSize;
-  _canvas.originalSize = savedPixmapSize;
+  _canvas.source = QPixmap::fromImage(project.source);
+  _canvas.size = project.originalSize;
+  _canvas.originalSize = project.originalSize;
   _canvas.pos = centerCanvas();
   generateToolBar();
 
-  // Read the drawings
-  for (int i=0; i<formListSize; i++) _forms.append(receiveForm(&in));
-
-  if (in.atEnd()) {
-    logUser(LOG_SUCCESS, "", "Recovery algorithm finished successfully (reached End Of File)");
-  } else {
-    logUser(LOG_ERROR_AND_EXIT, "", "There is data left in the ZoomMe file that was not loaded by the recovery algorithm (because it ended before the EOF). Please check the saving and the recovery algorithm: There may be some variables missing in the recovery and not in the saving or some variables added in the saving but not in the recovery...");
-  }
+  logUser(LOG_SUCCESS, "", "Recovery algorithm finished successfully (reached End Of File)");
+  return true;
 }
 
 void ZoomWidget::createVideoFFmpeg()
@@ -965,9 +1009,9 @@ void ZoomWidget::createVideoFFmpeg()
             << "-loglevel"  << "warning"
             << "-y"
   // INPUT ARGS
-            // No rawvideo because it's now compressed in jpeg
-            // << "-f"         << "rawvideo"
-            << "-pix_fmt"   << "yuv420p" // Indicates that the file contains JPEG images
+            // No rawvideo because it's now compressed in QOI or JPEG
+            << "-f"         << ((QString(RECORD_FRAME_FORMAT) == QOI_EXTENSION) ? "qoi_pipe" : "jpeg_pipe")
+            << "-pix_fmt"   << "yuv420p"
             << "-s"         << resolution
             << "-r"         << QString::number(RECORD_FPS)
             << "-i"         << _recordTempFile->fileName()
@@ -1019,111 +1063,19 @@ void ZoomWidget::createVideoFFmpeg()
 
 void ZoomWidget::saveFrameToFile()
 {
-  QImage image = _canvas.pixmap.toImage();
+  QImage image = getDrawnImage(_canvas.pixmap.rect());
 
-  // Save the image as jpeg into a byte array (is not a raw image, it's
-  // compressed)
+  // Save the image as QOI or JPEG into a byte array (is not a raw image, it's
+  // compressed). FFmpeg splits the frames when reading the file
   QByteArray imageBytes;
-  QBuffer buffer(&imageBytes); buffer.open(QIODevice::WriteOnly);
-  image.save(&buffer, "JPEG", RECORD_FRAME_QUALITY);
-
-  _recordTempFile->write(imageBytes);
-}
-
-QRect fixQRect(int x, int y, int width, int height)
-{
-  // The width and height of the rectangle must be positive, otherwise strange
-  // things happen, like only showing the first word on texts, or draw an
-  // ellipse instead of rectangles
-  if (width < 0)  { x+=width;  width=abs(width);   }
-  if (height < 0) { y+=height; height=abs(height); }
-
-  return QRect(x, y, width, height);
-}
-
-void updateFontSize(QPainter *painter)
-{
-  QFont font;
-  font.setPointSize(painter->pen().width() * FONT_SCALE);
-  painter->setFont(font);
-}
-
-void changePenWidth(QPainter *painter, int width)
-{
-  QPen pen = painter->pen();
-  pen.setWidth(width);
-  painter->setPen(pen);
-}
-
-// If the lineLength is 0, it will be calculated with the hypotenuse (the line)
-ArrowHead ZoomWidget::getArrowHead(const int x, const int y, const int width, const int height, int lineLength)
-{
-  const float opposite=-1 * height;
-  const float adjacent=width;
-  const float hypotenuse=sqrt(pow(opposite,2) + pow(adjacent,2));
-
-  float angle = (adjacent!=0) // Avoid dividing by 0
-                ? atanf(fabs(opposite) / fabs(adjacent))
-                : M_PI/2;
-
-  if (opposite>=0 && adjacent<0) {
-    angle = M_PI-angle;
-  } else if (opposite<0 && adjacent<=0) {
-    angle = M_PI+angle;
-  } else if (opposite<=0 && adjacent>0) {
-    angle = 2*M_PI-angle;
-  }
-
-  // This proportion determines the inclination of the arrowhead's lines.
-  // For example, when the arrow is horizontal, the X and Y lengths of the arrow
-  // should be the same. When it's at a 45º angle, the right-side line of the arrowhead
-  // in X should be 0%, while in Y it should be 100%. When the arrow is at 90º,
-  // the results should be the same as when it was horizontal, and so on...
-
-  // I concluded that the Y-axis should be the opposite of the X-axis on the right-
-  // side line of the arrowhead, and the left-side line of the arrowhead is
-  // the opposite of the right-side line of the arrowhead.
-
-  // I've simplified this behavior with a sinusoidal function, so that:
-  // 0º = 0.5 (min); 45º = 1 (max); 90º = 0.5(min); etc.
-  const float lengthProportion = 0.25 * sin(4*angle-(M_PI/2)) + 0.75;
-
-  // The line's length of the arrow head is a 15% of the main line size
-  if (lineLength == 0) {
-    lineLength = hypotenuse * 0.15;
-    if (lineLength > MAX_ARROWHEAD_LENGTH) lineLength=MAX_ARROWHEAD_LENGTH;
-  }
-
-  // Tip of the line where the arrow head should be drawn
-  int originX=width+x, originY=height+y;
-
-  int rightLineX = lineLength,
-      rightLineY = lineLength,
-      leftLineX  = lineLength,
-      leftLineY  = lineLength;
-
-  // Multiple the size with the direction in the axis
-  rightLineX *= (angle<=(  M_PI/4)) || (angle>(5*M_PI/4)) ? -1 : 1;
-  rightLineY *= (angle<=(3*M_PI/4)) || (angle>(7*M_PI/4)) ? 1 : -1;
-  leftLineX  *= (angle<=(3*M_PI/4)) || (angle>(7*M_PI/4)) ? -1 : 1;
-  leftLineY  *= (angle<=(  M_PI/4)) || (angle>(5*M_PI/4)) ? -1 : 1;
-
-  // Multiply the size with the proportion
-  const bool firstQuadrant = (angle<=(M_PI/2));
-  const bool thirdQuadrant = (angle>M_PI && angle<=(3*M_PI/2));
-  if (firstQuadrant || thirdQuadrant) {
-    rightLineX *= (1-lengthProportion); rightLineY *= lengthProportion;
-    leftLineX  *= lengthProportion;     leftLineY  *= (1-lengthProportion);
+  if (QString(RECORD_FRAME_FORMAT) == QOI_EXTENSION) {
+    imageBytes = encodeQoi(image);
   } else {
-    rightLineX *= lengthProportion;     rightLineY *= (1-lengthProportion);
-    leftLineX  *= (1-lengthProportion); leftLineY  *= lengthProportion;
+    QBuffer buffer(&imageBytes); buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPEG", RECORD_FRAME_QUALITY);
   }
 
-  return ArrowHead {
-    QPoint(originX, originY),
-    QPoint(originX+leftLineX, originY+leftLineY),
-    QPoint(originX+rightLineX, originY+rightLineY),
-  };
+  _recordTempFile->write(imageBytes);
 }
 
 bool ZoomWidget::isDrawingHovered(const int vectorPos)
@@ -1143,24 +1095,6 @@ bool ZoomWidget::isDrawingHovered(const int vectorPos)
   return (posFormBehindCursor==vectorPos);
 }
 
-QColor invertColor(QColor color)
-{
-  color.setRed(255 - color.red());
-  color.setGreen(255 - color.green());
-  color.setBlue(255 - color.blue());
-
-  return color;
-}
-
-void invertColorPainter(QPainter *painter)
-{
-  QPen pen = painter->pen();
-  QColor color = invertColor(pen.color());
-
-  pen.setColor(color);
-  painter->setPen(pen);
-}
-
 bool ZoomWidget::adjustFontSize(QFont *font, const QString text, const int rectWidth, const int minPointSize)
 {
   int fontSize = font->pointSize();
@@ -1245,19 +1179,22 @@ void ZoomWidget::drawButton(QPainter *screenPainter, const Button button)
   // Adjust the font size to the width.
   // Separate icon and text font because Hack Nerd Font gives problems when
   // calculating the width of a text.
-  QFont iconFont = QFont("Hack Nerd Font", maxFontSize);
-  screenPainter->setFont(iconFont);
-
   QFont textFont = QApplication::font(); // Default system font
   textFont.setPointSize(maxFontSize);
   bool displayText = adjustFontSize(&textFont, button.name, button.rect.width()-textMargin*2, minFontSize);
 
+  // The icon is blitted from the atlas (in the first line of the button if
+  // there's text, otherwise in the center)
+  const int iconHeight = _iconAtlas.lineHeight();
+  const QRect iconLine(button.rect.x(),
+                       button.rect.center().y() - (displayText ? iconHeight : iconHeight/2),
+                       button.rect.width(),
+                       iconHeight);
+  _iconAtlas.drawIcon(screenPainter, iconLine, button.icon, screenPainter->pen().color());
+
   if (displayText) {
-    screenPainter->drawText(button.rect, Qt::AlignCenter | Qt::TextWrapAnywhere, button.icon+"\n");
     screenPainter->setFont(textFont);
     screenPainter->drawText(button.rect, Qt::AlignCenter | Qt::TextWrapAnywhere, "\n" + button.name);
-  } else {
-    screenPainter->drawText(button.rect, Qt::AlignCenter | Qt::TextWrapAnywhere, button.icon);
   }
 }
 
@@ -1546,6 +1483,7 @@ void ZoomWidget::drawPopupTray(QPainter *screenPainter)
 void ZoomWidget::drawStatus(QPainter *screenPainter)
 {
   if (_screenOpts == SCREENOPTS_HIDE_ALL || _screenOpts == SCREENOPTS_HIDE_FLOATING) {
+    _statusRect = QRect();
     return;
   }
 
@@ -1606,6 +1544,10 @@ void ZoomWidget::drawStatus(QPainter *screenPainter)
     text += "\n-- SELECT --";
   }
 
+  if (_loadingClipboard) {
+    text.append("\n-- LOADING THE CLIPBOARD --");
+  }
+
   // Last Line
   if (IS_RECORDING) {
     text.append("\n");
@@ -1645,6 +1587,10 @@ void ZoomWidget::drawStatus(QPainter *screenPainter)
         h
       );
 
+  // The status box has to be repainted in live mode when the cursor moves near
+  // it (see updateLiveRegion())
+  _statusRect = background.adjusted(-borderWidth, -borderWidth, borderWidth, borderWidth);
+
   // If the mouse is near the hit box, don't draw it
   QRect hitBox(
         background.x() - borderWidth/2 - margin,
@@ -1689,114 +1635,15 @@ void ZoomWidget::drawStatus(QPainter *screenPainter)
   screenPainter->drawText(textRect, Qt::AlignCenter | Qt::TextWordWrap, text);
 }
 
-ArrowHead ZoomWidget::getFreeFormArrowHead(const Form freeForm)
-{
-  const int pointsCount = 8; // Number of points to take the average for the arrow head start
-  const int minPointDistance = 5; // Minimal pixel of the distance between the points for the average
-  const int lineSize = MAX_ARROWHEAD_LENGTH / 2;
-
-  if (freeForm.points.size() <= pointsCount) { // Too short
-    return ArrowHead {
-      QPoint(0,0),
-      QPoint(0,0),
-      QPoint(0,0)
-    };
-  }
-
-  // Get the points for the average
-  QList<QPoint> points;
-  points.append(freeForm.points.at(freeForm.points.size()-2));
-  for (int i=freeForm.points.size()-2; i>0; i--) { // It start from the penultimate to give more importance to that last point
-    if (points.size() == pointsCount) {
-      break;
-    }
-
-    const QPoint newPoint = freeForm.points.at(i);
-    const QPoint last = points.last();
-
-    float distance = hypot(newPoint.x() - last.x(), newPoint.y() - last.y());
-
-    if (distance > minPointDistance) {
-      points.append(newPoint);
-    }
-  }
-
-  QPoint start(0,0);
-  for (int i=0; i < points.size(); i++) {
-    start += points.at(i) / points.size();
-  }
-
-  return getArrowHead(
-        start.x(),
-        start.y(),
-        freeForm.points.last().x() - start.x(),
-        freeForm.points.last().y() - start.y(),
-        lineSize
-      );
-}
-
-QList<int> ZoomWidget::getFreeFormWidth(const Form form)
+int ZoomWidget::getFreeFormWidth(const qreal speed)
 {
-  const int minWidth  = 1 * LINE_WIDTH_SCALE;
-  const int maxWidth  = 9 * LINE_WIDTH_SCALE;
-  QList<int> widths;
-
-  // If there's no enough points, return the width of the form.
-  // When saving, it only saves the free forms with more than 1 point. I leave
-  // this check just to be sure
-  if (form.points.size() < 2) {
-    logUser(LOG_ERROR, "", "Not enough point in the free form to calculate the dynamic width");
-    return widths;
-  }
-
   if (!_dynamicWidth) {
-    for (int i=0; i<form.points.size()-1; i++) widths.append(form.pen.width());
-    return widths;
-  }
-
-  // Initialize min and max distance values
-  const int hypotFirst = hypot(
-        form.points.at(1).x() - form.points.at(0).x(),
-        form.points.at(1).y() - form.points.at(0).y()
-      );
-  int minPixels = hypotFirst;
-  int maxPixels = hypotFirst;
-
-  for (int i=1; i<form.points.size()-1; i++) {
-    const QPoint point = form.points.at(i);
-    const QPoint next = form.points.at(i+1);
-    const int hypotenuse = hypot(next.x() - point.x(), next.y() - point.y());
-
-    if (hypotenuse > maxPixels) {
-      maxPixels = hypotenuse;
-    }
-    if (hypotenuse < minPixels) {
-      minPixels = hypotenuse;
-    }
+    return _activePen.width();
   }
 
-  // Populate the array with the widths
-  for (int i=0; i<form.points.size()-1; i++) {
-    const QPoint point = form.points.at(i);
-    const QPoint next = form.points.at(i+1);
-    const int hypotenuse = hypot(next.x() - point.x(), next.y() - point.y());
-
-    // The Rule of Three
-    // const int width = (hypotenuse-minPixels) * (maxWidth-minWidth) / (maxPixels-minPixels) + minWidth;
-    // Percentage of the max pixels of distance
-    int width = (float)(hypotenuse-minPixels) / (float)(maxPixels-minPixels) * (float)(maxWidth-minWidth) + minWidth;
-
-    if (width > maxWidth) width = maxWidth;
-    if (width < minWidth) width = minWidth;
-
-    widths.append(width);
-  }
-
-  if ((form.points.size()-1) != widths.size()) {
-    logUser(LOG_ERROR, "", "Couldn't calculate the pen's width for each point in the free form");
-  }
-
-  return widths;
+  // The faster the pointer moves, the wider the line
+  const qreal fraction = qMin<qreal>(speed / DYNAMIC_WIDTH_MAX_SPEED, 1.0);
+  return qRound(DYNAMIC_WIDTH_MIN + fraction * (DYNAMIC_WIDTH_MAX - DYNAMIC_WIDTH_MIN)) * LINE_WIDTH_SCALE;
 }
 
 void ZoomWidget::drawSavedForms(QPainter *pixmapPainter)
@@ -1805,143 +1652,8 @@ void ZoomWidget::drawSavedForms(QPainter *pixmapPainter)
     return;
   }
 
-  int x, y, w, h;
   for (int i = 0; i < _forms.size(); ++i) {
-    Form f = _forms.at(i);
-    if (!f.deleted) {
-      pixmapPainter->setPen(f.pen);
-      if (isDrawingHovered(i)) invertColorPainter(pixmapPainter);
-
-      switch (f.type) {
-        case RECTANGLE:
-          getSimpleFormPosition(f, &x, &y, &w, &h, false);
-
-          if (f.highlight) {
-            QColor color = pixmapPainter->pen().color();
-            color.setAlpha(HIGHLIGHT_ALPHA); // Transparency
-            QPainterPath background;
-            background.addRoundedRect(x, y, w, h, RECT_ROUNDNESS, RECT_ROUNDNESS);
-            pixmapPainter->fillPath(background, color);
-          }
-
-          pixmapPainter->drawRoundedRect(fixQRect(x, y, w, h), RECT_ROUNDNESS, RECT_ROUNDNESS);
-          break;
-
-        case LINE:
-          getSimpleFormPosition(f, &x, &y, &w, &h, false);
-
-          // Draw a wider semi-transparent line behind the line as the highlight
-          if (f.highlight) {
-            QPen oldPen = pixmapPainter->pen();
-
-            // Change the color and width of the pen
-            QPen newPen = oldPen;
-            QColor color = oldPen.color(); color.setAlpha(HIGHLIGHT_ALPHA); newPen.setColor(color);
-            newPen.setWidth(newPen.width() * 4);
-            pixmapPainter->setPen(newPen);
-
-            pixmapPainter->drawLine(x, y, x+w, y+h);
-
-            // Reset pen
-            pixmapPainter->setPen(oldPen);
-          }
-
-          if (f.arrow) {
-            ArrowHead head = getArrowHead(x, y, w, h, 0);
-            pixmapPainter->drawLine(head.startPoint, head.rightLineEnd);
-            pixmapPainter->drawLine(head.startPoint, head.leftLineEnd);
-          }
-
-          pixmapPainter->drawLine(x, y, x+w, y+h);
-          break;
-
-        case ELLIPSE:
-          getSimpleFormPosition(f, &x, &y, &w, &h, false);
-
-          if (f.highlight) {
-            QColor color = pixmapPainter->pen().color();
-            color.setAlpha(HIGHLIGHT_ALPHA); // Transparency
-            QPainterPath background;
-            background.addEllipse(x, y, w, h);
-            pixmapPainter->fillPath(background, color);
-          }
-
-          pixmapPainter->drawEllipse(x, y, w, h);
-          break;
-
-        case TEXT:
-          // If the last one is currently active (user is typing), draw it in the
-          // "active text" `if` statement
-          if (!f.active) {
-            updateFontSize(pixmapPainter);
-            getSimpleFormPosition(f, &x, &y, &w, &h, false);
-
-            if (f.highlight) {
-              QColor color = pixmapPainter->pen().color();
-              color.setAlpha(HIGHLIGHT_ALPHA); // Transparency
-              QPainterPath background;
-              background.addRoundedRect(x, y, w, h, RECT_ROUNDNESS, RECT_ROUNDNESS);
-              pixmapPainter->fillPath(background, color);
-              pixmapPainter->drawRoundedRect(fixQRect(x, y, w, h), RECT_ROUNDNESS, RECT_ROUNDNESS);
-            }
-
-            QString text = f.text;
-            QRect textRect = fixQRect(x, y, w, h);
-            // Don't draw the text over the border (when highlighted)
-            textRect.setX(textRect.x() + pixmapPainter->pen().width()/2);
-            textRect.setY(textRect.y() + pixmapPainter->pen().width()/2);
-            // If the inside border is bigger than the width, don't overflow to negative width
-            if (abs(textRect.width()) > pixmapPainter->pen().width()/2) {
-              textRect.setWidth(textRect.width() - pixmapPainter->pen().width()/2);
-            } else {
-              textRect.setWidth(0);
-            }
-            // If the inside border is bigger than the height, don't overflow to negative height
-            if (abs(textRect.height()) > pixmapPainter->pen().width()/2) {
-              textRect.setHeight(textRect.height() - pixmapPainter->pen().width()/2);
-            } else {
-              textRect.setHeight(0);
-            }
-
-            pixmapPainter->drawText(textRect, Qt::AlignCenter | Qt::TextWordWrap, text);
-            break;
-          }
-
-        case FREEFORM:
-          // If the is currently active, draw it in the "active forms" switch
-          if (!f.active) {
-            // Draw the free form with or without the highlight
-            if (f.highlight) {
-              QPolygon polygon(f.points);
-
-              // Highlight
-              QColor color = pixmapPainter->pen().color();
-              color.setAlpha(HIGHLIGHT_ALPHA); // Transparency
-              QPainterPath background;
-              background.addPolygon(polygon);
-              pixmapPainter->fillPath(background, color);
-              // You can't draw a highlighted arrow in free form
-
-              pixmapPainter->drawPolygon(polygon);
-            } else {
-              for (int z = 0; z < f.points.size()-1; ++z) {
-                QPoint current = f.points.at(z);
-                QPoint next    = f.points.at(z+1);
-
-                changePenWidth(pixmapPainter, f.penWidths.at(z));
-
-                pixmapPainter->drawLine(current.x(), current.y(), next.x(), next.y());
-              }
-              if (f.arrow) {
-                ArrowHead head = getFreeFormArrowHead(f);
-                pixmapPainter->drawLine(head.startPoint, head.rightLineEnd);
-                pixmapPainter->drawLine(head.startPoint, head.leftLineEnd);
-              }
-            }
-          }
-          break;
-      }
-    }
+    drawForm(pixmapPainter, _forms.at(i), isDrawingHovered(i));
   }
 }
 
@@ -1968,7 +1680,7 @@ void ZoomWidget::drawFlashlightEffect(QPainter *painter, const bool drawToScreen
   // painter->drawEllipse( mouseFlashlightBorder );
 
   QPainterPath pixmapPath;
-  pixmapPath.addRect(_canvas.pixmap.rect());
+  pixmapPath.addRect(_canvas.source.rect());
 
   QPainterPath flashlightArea = pixmapPath.subtracted(mouseFlashlight);
   painter->fillPath(flashlightArea, QColor(  0,  0,  0, 190));
@@ -1981,7 +1693,7 @@ void ZoomWidget::drawTrimmed(QPainter *pixmapPainter)
   mouseFlashlight.addRect(rect);
 
   QPainterPath pixmapPath;
-  pixmapPath.addRect(_canvas.pixmap.rect());
+  pixmapPath.addRect(_canvas.source.rect());
 
   QPainterPath opaqueArea = pixmapPath.subtracted(mouseFlashlight);
   pixmapPainter->fillPath(opaqueArea, QColor(  0,  0,  0, 190));
@@ -2154,37 +1866,32 @@ void ZoomWidget::drawActiveForm(QPainter *painter, bool drawToScreen)
           break;
         }
 
-        Form f = _forms.last();
+        const Form &f = _forms.last();
 
         if (f.type != FREEFORM || !f.active) {
           break;
         }
 
         // Draw the free form with or without the highlight
-        if (_highlight) {
-          QPolygon polygon;
-          for (int i = 0; i < f.points.size(); ++i) {
-            QPoint point = f.points.at(i);
-            if (drawToScreen) point = pixmapPointToScreenPos(point);
-
-            polygon << point;
-          }
+        const QPolygon polygon = drawToScreen ? pixmapPointsToScreenPos(f.points) : QPolygon(f.points);
 
+        if (_highlight) {
           background.addPolygon(polygon);
           painter->fillPath(background, color);
           // You can't draw a highlighted arrow in free form
 
           painter->drawPolygon(polygon);
         } else {
-          for (int i = 0; i < f.points.size()-1; ++i) {
-            QPoint current = f.points.at(i);
-            QPoint next    = f.points.at(i+1);
+          // Like the outline of the saved form (see freeFormOutline())
+          QPen pen = painter->pen();
+          pen.setCapStyle(Qt::RoundCap);
+          painter->setPen(pen);
 
-            if (drawToScreen) {
-              current = pixmapPointToScreenPos(current);
-              next = pixmapPointToScreenPos(next);
-            }
+          for (int i = 0; i < polygon.size()-1; ++i) {
+            const QPoint current = polygon.at(i);
+            const QPoint next    = polygon.at(i+1);
 
+            changePenWidth(painter, f.penWidths.at(i));
             painter->drawLine(current.x(), current.y(), next.x(), next.y());
           }
 
@@ -2256,10 +1963,10 @@ void ZoomWidget::drawAllNodes(QPainter *screenPainter)
 
   for (int i=0; i<_forms.size(); i++) {
     if (!_forms.at(i).deleted && _forms.at(i).type==_drawMode && _forms.at(i).type != FREEFORM) {
-      QList<QPoint> p = _forms.at(i).points;
+      const QPolygon p = pixmapPointsToScreenPos(_forms.at(i).points);
 
       for (int x=0; x<p.size(); x++) {
-        drawNode(screenPainter, pixmapPointToScreenPos(p.at(x)));
+        drawNode(screenPainter, p.at(x));
       }
     }
   }
@@ -2273,7 +1980,7 @@ void ZoomWidget::drawAllHandles(QPainter *screenPainter)
 
   for (int i=0; i<_forms.size(); i++) {
     if (!_forms.at(i).deleted && _forms.at(i).type==_drawMode) {
-      QList<QPoint> p = _forms.at(i).points;
+      const QList<QPoint> &p = _forms.at(i).points;
       QPoint handle;
 
       if (!p.isEmpty()) {
@@ -2298,74 +2005,110 @@ void ZoomWidget::paintEvent(QPaintEvent *event)
     logUser(LOG_ERROR_AND_EXIT, "", "The desktop pixmap is null. Can't paint over a null pixmap");
   }
 
-  // When changing between fullscreen and window (and changing its size)
-  if (_windowSize != event->rect().size()) {
-    _windowSize = event->rect().size();
+  applyFonts();
+  flushFreeFormSamples();
+
+  // When changing between fullscreen and window (and changing its size). The
+  // size of the widget is used, because the event can be of a damaged region
+  if (_windowSize != size()) {
+    _windowSize = size();
     generateToolBar();
     if (!isDisabledMouseTracking()) _canvas.pos = centerCanvas();
     if (_liveMode) {
-      _canvas.source = QPixmap(_windowSize);
+      _canvas.source = QPixmap(_windowSize * _desktopScreen->devicePixelRatio());
+      _canvas.source.fill(Qt::transparent);
       _canvas.size = _windowSize;
       _canvas.originalSize = _windowSize;
     }
   }
 
-  _canvas.pixmap = _canvas.source;
+  // Live mode has no background, so (unless the pixmap is needed to record or
+  // pick colors) the forms are drawn straight onto the translucent window. The
+  // painter is clipped to the damaged region (see updateLiveRegion()), so only
+  // that part is drawn and blended by the compositor, instead of filling and
+  // compositing a pixmap of the whole window every frame
+  const bool liveZoom     = _liveMode && _canvas.scale > 1.0f;
+  const bool drawOnWindow = _liveMode && !liveZoom && !IS_RECORDING && _state != STATE_COLOR_PICKER;
 
-  if (_liveMode) {
-    _canvas.pixmap.fill(Qt::transparent);
-  }
+  QPainter pixmapPainter;
+  QPainter screen; screen.begin(this);
 
-  if (_boardMode) {
-    _canvas.pixmap.fill(QCOLOR_BLACKBOARD);
-  }
+  if (drawOnWindow) {
+    if (_boardMode) {
+      screen.fillRect(rect(), QCOLOR_BLACKBOARD);
+    }
 
-  QPainter pixmapPainter(&_canvas.pixmap);
-  QPainter screen; screen.begin(this);
+    // The saved forms are in the pixmap
+    screen.setTransform(viewTransform());
+    drawSavedForms(&screen);
+    if (_state == STATE_TRIMMING) {
+      drawTrimmed(&screen);
+    }
+    screen.resetTransform();
 
-  drawSavedForms(&pixmapPainter);
-  if (_state == STATE_TRIMMING) {
-    drawTrimmed(&pixmapPainter);
-  }
-
-  // By drawing the active form in the pixmap, it gives a better user feedback
-  // (because the user can see how it would really look like when saved), but
-  // when the flashlight effect is on, its better to draw the active form onto
-  // the screen, on top of the flashlight effect, so that the user can see the
-  // active form over the opaque background. This can cause some differences
-  // with the final result (like the width of the pen and the size of the
-  // arrow's head)
-  // By the way, ¿Why would you draw when the flashlight effect is enabled? I
-  // don't know why I'm allowing this... You can't even see the cursor!
-  if (_flashlightMode && !IS_RECORDING) {
-    drawDrawnPixmap(&screen);
-    drawFlashlightEffect(&screen, true);
+    if (_flashlightMode) {
+      drawFlashlightEffect(&screen, true);
+    }
     drawActiveForm(&screen, true);
   } else {
-    if (_flashlightMode) {
-      drawFlashlightEffect(&pixmapPainter, false);
+    _canvas.pixmap = _canvas.source;
+
+    // With the regions of a huge image or the tiles of the screens, the
+    // drawings are a transparent layer (see drawDrawnPixmap()). When zooming in
+    // live mode, the source has the captured desktop
+    if ((_liveMode && !liveZoom) || isDrawingLayer()) {
+      _canvas.pixmap.fill(Qt::transparent);
+    }
+
+    if (_boardMode) {
+      _canvas.pixmap.fill(QCOLOR_BLACKBOARD);
+    }
+
+    pixmapPainter.begin(&_canvas.pixmap);
+
+    drawSavedForms(&pixmapPainter);
+    if (_state == STATE_TRIMMING) {
+      drawTrimmed(&pixmapPainter);
+    }
+
+    // By drawing the active form in the pixmap, it gives a better user feedback
+    // (because the user can see how it would really look like when saved), but
+    // when the flashlight effect is on, its better to draw the active form onto
+    // the screen, on top of the flashlight effect, so that the user can see the
+    // active form over the opaque background. This can cause some differences
+    // with the final result (like the width of the pen and the size of the
+    // arrow's head)
+    // By the way, ¿Why would you draw when the flashlight effect is enabled? I
+    // don't know why I'm allowing this... You can't even see the cursor!
+    if (_flashlightMode && !IS_RECORDING) {
+      drawDrawnPixmap(&screen);
+      drawFlashlightEffect(&screen, true);
+      drawActiveForm(&screen, true);
+    } else {
+      if (_flashlightMode) {
+        drawFlashlightEffect(&pixmapPainter, false);
+      }
+      drawActiveForm(&pixmapPainter, false);
+      drawDrawnPixmap(&screen);
     }
-    drawActiveForm(&pixmapPainter, false);
-    drawDrawnPixmap(&screen);
   }
 
   if (_grid) {
     QPen pen;
     pen.setColor(QCOLOR_GRID);
     pen.setWidth(GRID_WIDTH * LINE_WIDTH_SCALE);
+    pen.setCosmetic(true); // The width is in the screen, not in the pixmap
     screen.setPen(pen);
 
-    for (int i=0; i<_canvas.pixmap.size().height(); i+=GRID_DISTANCE_Y)
-      screen.drawLine(
-            pixmapPointToScreenPos(QPoint(0, i)),
-            pixmapPointToScreenPos(QPoint(_canvas.pixmap.size().width(), i))
-          );
+    // The lines are in the pixmap, and the painter maps them to the screen
+    screen.save();
+    screen.setTransform(viewTransform());
+    for (int i=0; i<_canvas.source.size().height(); i+=GRID_DISTANCE_Y)
+      screen.drawLine(0, i, _canvas.source.size().width(), i);
 
-    for (int i=0; i<_canvas.pixmap.size().width(); i+=GRID_DISTANCE_X)
-      screen.drawLine(
-            pixmapPointToScreenPos(QPoint(i, 0)),
-            pixmapPointToScreenPos(QPoint(i, _canvas.pixmap.size().height()))
-          );
+    for (int i=0; i<_canvas.source.size().width(); i+=GRID_DISTANCE_X)
+      screen.drawLine(i, 0, i, _canvas.source.size().height());
+    screen.restore();
   }
 
   if (_state == STATE_RESIZE_FORM) {
@@ -2383,7 +2126,15 @@ void ZoomWidget::paintEvent(QPaintEvent *event)
   }
 
   screen.end();
-  pixmapPainter.end();
+  if (pixmapPainter.isActive()) {
+    pixmapPainter.end();
+  }
+
+  if (!_firstFramePainted) {
+    _firstFramePainted = true;
+    finishStartupProfile();
+    emit firstFramePainted();
+  }
 }
 
 // The cursor pos shouln't be fixed to hdpi scaling
@@ -2424,17 +2175,16 @@ bool ZoomWidget::isCursorOverNode(const QPoint cursorPos, const QPoint point)
 bool ZoomWidget::selectHandle(const QPoint cursorPos)
 {
   for (int i=0; i<_forms.size(); i++) {
-    const Form f = _forms.at(i);
+    const Form &f = _forms.at(i);
     QPoint handle;
 
     if (!f.deleted && f.type==_drawMode) {
       for (int x=0; x<f.points.size(); x++) {
-        const QPoint p = pixmapPointToScreenPos(f.points.at(x));
-        handle += p;
+        handle += f.points.at(x);
       }
 
       if (!f.points.isEmpty()) {
-        handle /= f.points.size();
+        handle = pixmapPointToScreenPos(handle / f.points.size());
 
         if (isCursorOverNode(cursorPos,handle)) {
           // Put the form at the top of the list
@@ -2456,13 +2206,12 @@ bool ZoomWidget::selectHandle(const QPoint cursorPos)
 bool ZoomWidget::selectNode(const QPoint cursorPos)
 {
   for (int i=0; i<_forms.size(); i++) {
-    const Form f = _forms.at(i);
+    const Form &f = _forms.at(i);
 
     if (!f.deleted && f.type==_drawMode && f.type != FREEFORM) {
-      for (int x=0; x<f.points.size(); x++) {
-        const QPoint p = pixmapPointToScreenPos(f.points.at(x));
-
-        if (isCursorOverNode(cursorPos, p)) {
+      const QPolygon points = pixmapPointsToScreenPos(f.points);
+      for (int x=0; x<points.size(); x++) {
+        if (isCursorOverNode(cursorPos, points.at(x))) {
           // Put the form at the top of the list
           Form f = _forms.takeAt(i);
           _forms.append(f);
@@ -2501,19 +2250,19 @@ void ZoomWidget::moveForm(QPoint cursorPos)
     return;
   }
 
-  Form f = _forms.takeLast();
+  Form &f = _forms.last();
 
   QPoint handle;
   for (int i=0; i<f.points.size(); i++) handle += f.points.at(i);
   handle /= f.points.size();
 
+  const QPoint offset = cursorPos - handle;
   for (int i=0; i<f.points.size(); i++) {
-    QPoint p = f.points.takeAt(i);
-    p = p - handle + cursorPos;
-    f.points.insert(i, p);
+    f.points[i] += offset;
   }
 
-  _forms.append(f);
+  // The shape doesn't change, so the outline is just moved
+  f.outline.translate(offset);
 }
 
 void ZoomWidget::mousePressEvent(QMouseEvent *event)
@@ -2538,6 +2287,10 @@ void ZoomWidget::mousePressEvent(QMouseEvent *event)
     return;
   }
 
+  if (_loadingClipboard) {
+    return;
+  }
+
   // Drag the pixmap
   if (event->button() == DRAG_MOUSE_BUTTON && isDisabledMouseTracking()) {
     _canvas.dragging = true;
@@ -2615,6 +2368,11 @@ void ZoomWidget::mousePressEvent(QMouseEvent *event)
     data.points.append(screenPointToPixmapPos(cursorPos));
     _forms.append(data);
     _state = STATE_DRAWING;
+    _pendingSamples.clear();
+    _tabletStroke = false;
+    // The samples are in the pixmap, and the zoom can't change while drawing
+    _strokeFilter.reset(data.points.first(), event->timestamp(), viewTransform().m11());
+    setPointerEventsCompressed(false);
     update();
     return;
   }
@@ -2629,98 +2387,59 @@ void ZoomWidget::mousePressEvent(QMouseEvent *event)
 
 // If toImage it's true, then it's saved in a image file, otherwise, it gets
 // saved in the clipboard
-void ZoomWidget::saveImage(const QPixmap pixmap, const bool toImage)
+void ZoomWidget::saveImage(const QRect area, const bool toImage)
 {
-  if (toImage) {
-     QString path = getFilePath(FILE_IMAGE);
-     if (pixmap.save(path)) {
-       QApplication::beep();
-       logUser(LOG_SUCCESS, "Image saved correctly!", "Image saved correctly: %s", QSTRING_TO_STRING(path));
-     } else {
-       logUser(LOG_ERROR, "", "Couldn't save the picture to: %s", QSTRING_TO_STRING(path));
-     }
-     return;
-  }
-
-  // Clipboard
-#ifdef Q_OS_LINUX
-  // Save the image in a temp folder and load it to the clipboard with
-  // xclip, because with QClipboard in linux, the image gets deleted when
-  // closing the app. Apparently in other systems the other way (copying
-  // the image directly to the clipboard) work just fine
-  QDir tempFile(QStandardPaths::writableLocation(QStandardPaths::TempLocation));
-  QString fileName(CLIPBOARD_TEMP_FILENAME); fileName.append(".png");
-  QString path(tempFile.absoluteFilePath(fileName));
-
-  if (!pixmap.save(path)) {
-    logUser(LOG_ERROR, "", "Couldn't save the image to the temp location for the clipboard: %s", QSTRING_TO_STRING(path));
+  if (toImage && _fileConfig.toStdout) {
+    saveToStdout(area);
     return;
   }
 
-  QProcess process;
-  QString appName;
-  if (QGuiApplication::platformName() == QString("wayland")) {
-    appName = "wl-copy";
-
-    process.setProgram("bash");
-    QList<QString> procArgs;
-    procArgs << "-c" << QString("wl-copy < " + path);
-    process.setArguments(procArgs);
-  } else { // X11
-    appName = "xclip";
-    process.setProgram(appName);
-
-    QList<QString> procArgs;
-    procArgs << "-selection" << "clipboard"
-      << "-target"    << "image/png"
-      << "-i"         << path;
-    process.setArguments(procArgs);
+  if (toImage && isVectorFormat(_fileConfig.imageExt)) {
+    saveVectorImage(area);
+    return;
   }
 
-  logUser(LOG_TEXT, "", "Trying to save the image to the clipboard with %s...", QSTRING_TO_STRING(appName));
-  process.start();
-  process.setProcessChannelMode(process.ForwardedChannels);
-
-  // Check for errors.
-  if (!process.waitForStarted(5000)) {
-    logUser(LOG_ERROR, "", "Couldn't start %s, maybe is not installed...", QSTRING_TO_STRING(appName));
-    logUser(LOG_TEXT, "", "  - Error: %s", QSTRING_TO_STRING(process.errorString()));
-    logUser(LOG_TEXT, "", "  - Executed command: %s %s", QSTRING_TO_STRING(process.program()), QSTRING_TO_STRING(process.arguments().join(" ")));
-    process.kill();
-  } else if (!process.waitForFinished(-1)) {
-    logUser(LOG_ERROR, "", "An error occurred with %s: %s", QSTRING_TO_STRING(appName), QSTRING_TO_STRING(process.errorString()));
-  } else if (process.exitStatus() == QProcess::CrashExit) {
-    logUser(LOG_ERROR, "", "%s crashed", QSTRING_TO_STRING(appName));
-  } else if (process.exitCode() != 0) {
-    logUser(LOG_ERROR, "", "%s failed. Exit code: %d", QSTRING_TO_STRING(appName), process.exitCode());
-  }
-
-  // If there's no errors, beep and exit
-  else {
-    logUser(LOG_SUCCESS, "","Saving image to clipboard with %s was successful!", QSTRING_TO_STRING(appName));
-    QApplication::beep();
+  // In live mode the pixmap isn't drawn (the forms are drawn on the window),
+  // and it can have only the drawings (see isDrawingLayer()), so the forms are
+  // rendered by the exporter over the background
+  if (_fileConfig.exportScale > 1 || _liveMode || isDrawingLayer()) {
+    saveScaledImage(area, toImage);
     return;
   }
 
-  // If there's an error with 'xclip' or 'wl-copy', copy the image path
-  // with Qt, not the image itself.
-  //
-  // Some apps will not fully recognize the image, because
-  // there's not a standard way to save a path in linux afaik (in example,
-  // Dolphin will copy the image, but Thunar and GIMP will not recognize
-  // it).
-  if (!_clipboard) {
-   logUser(LOG_ERROR, "", "There's no clipboard to save the image into");
-   return;
+  const QPixmap pixmap = (area == _canvas.pixmap.rect()) ? _canvas.pixmap : _canvas.pixmap.copy(area);
+
+  if (toImage) {
+     // Encoding and writing the image is done by the exporter thread, with a
+     // snapshot of the pixmap. The path is reserved until it's saved, so that
+     // the following exports don't get the same path
+     const QString path = getFilePath(FILE_IMAGE);
+     const QImage snapshot = pixmap.toImage();
+     _pendingExports.append(path);
+
+     ImageExporter *exporter = _exporter;
+     QMetaObject::invokeMethod(exporter, [exporter, snapshot, path]() {
+       exporter->saveImage(snapshot, path);
+     }, Qt::QueuedConnection);
+     return;
   }
 
-  logUser(LOG_TEXT, "", "Saving the image path to the clipboard");
-  QMimeData *mimeData = new QMimeData();
-  QList<QUrl> urlList; urlList.append(QUrl::fromLocalFile(path));
-  mimeData->setUrls(urlList);
-  _clipboard->setMimeData(mimeData);
-  logUser(LOG_SUCCESS, "", "Image path saved to clipboard successfully!");
-  QApplication::beep();
+  // Clipboard
+#ifdef Q_OS_LINUX
+  // Load the image to the clipboard with xclip or wl-copy, because with
+  // QClipboard in linux, the image gets deleted when closing the app.
+  // Apparently in other systems the other way (copying the image directly to
+  // the clipboard) work just fine.
+  // The image is encoded by the exporter thread, and then the bytes are
+  // streamed to the clipboard manager (see pipeToClipboard())
+  const QImage snapshot = pixmap.toImage();
+  const QString format  = _fileConfig.clipboardExt;
+  const int quality     = (format == "png") ? CLIPBOARD_PNG_QUALITY : -1;
+
+  ImageExporter *exporter = _exporter;
+  QMetaObject::invokeMethod(exporter, [exporter, snapshot, format, quality]() {
+    exporter->encodeImage(snapshot, format, quality);
+  }, Qt::QueuedConnection);
 #else
   // Copy the image into clipboard (this causes some problems with the
   // clipboard manager in Linux, because when the app exits, the image gets
@@ -2737,10 +2456,251 @@ void ZoomWidget::saveImage(const QPixmap pixmap, const bool toImage)
 #endif
 }
 
-void ZoomWidget::mouseReleaseEvent(QMouseEvent *event)
+void ZoomWidget::saveVectorImage(const QRect area)
 {
-  // The cursor pos is relative to the resolution of scaled monitor
-  const QPoint cursorPos = event->pos();
+  // In live mode there's no background (the desktop is behind the window)
+  Project project;
+  project.source = (_liveMode) ? QImage() : getExportBackground();
+  project.forms  = _forms;
+
+  const QString path = getFilePath(FILE_IMAGE);
+  _pendingExports.append(path);
+
+  ImageExporter *exporter = _exporter;
+  QMetaObject::invokeMethod(exporter, [exporter, project, area, path]() {
+    exporter->saveVectorImage(project, area, path);
+  }, Qt::QueuedConnection);
+}
+
+void ZoomWidget::saveToStdout(const QRect area)
+{
+  // Only one image is written (the app exits when it's done)
+  if (_pendingExports.contains(STDIO_PATH)) {
+    return;
+  }
+
+  Project project;
+  project.source = (_liveMode && isVectorFormat(_fileConfig.imageExt)) ? QImage() : getExportBackground();
+  project.forms  = _forms;
+  const int scale      = _fileConfig.exportScale;
+  const QString format = _fileConfig.imageExt;
+
+  _pendingExports.append(STDIO_PATH);
+
+  ImageExporter *exporter = _exporter;
+  QMetaObject::invokeMethod(exporter, [exporter, project, area, scale, format]() {
+    exporter->saveToStdout(project, area, scale, format);
+  }, Qt::QueuedConnection);
+}
+
+QImage ZoomWidget::getExportBackground()
+{
+  if (_liveMode) {
+    QImage background(_canvas.source.size(), QImage::Format_ARGB32_Premultiplied);
+    background.fill(Qt::transparent);
+    return background;
+  }
+
+  if (_boardMode) {
+    QImage background(_canvas.source.size(), QImage::Format_RGB32);
+    background.fill(QCOLOR_BLACKBOARD);
+    return background;
+  }
+
+  if (!_screenTiles.isEmpty()) {
+    return getScreenTilesImage();
+  }
+
+  return _canvas.source.toImage();
+}
+
+QImage ZoomWidget::getScreenTilesImage()
+{
+  QImage image(_canvas.source.size(), QImage::Format_RGB32);
+  image.fill(QCOLOR_BLACKBOARD); // The gaps between the screens
+  QPainter painter(&image);
+  drawScreenTiles(&painter, QRectF(image.rect()));
+  painter.end();
+
+  return image;
+}
+
+bool ZoomWidget::isDrawingLayer()
+{
+  return _imageDetail.isEnabled() || !_screenTiles.isEmpty();
+}
+
+QImage ZoomWidget::getDrawnImage(const QRect area)
+{
+  if (!isDrawingLayer()) {
+    return (area == _canvas.pixmap.rect()) ? _canvas.pixmap.toImage() : _canvas.pixmap.copy(area).toImage();
+  }
+
+  // Only the area is painted (the painter clips the rest)
+  QImage image(area.size(), QImage::Format_ARGB32_Premultiplied);
+  image.fill(QCOLOR_BLACKBOARD);
+  QPainter painter(&image);
+  painter.translate(-area.topLeft());
+  if (_screenTiles.isEmpty()) {
+    painter.drawPixmap(0, 0, _canvas.source);
+  } else {
+    drawScreenTiles(&painter, QRectF(_canvas.source.rect()));
+  }
+  painter.drawPixmap(0, 0, _canvas.pixmap);
+  painter.end();
+
+  return image;
+}
+
+void ZoomWidget::saveScaledImage(const QRect area, const bool toImage)
+{
+  // The exporter draws the forms again over the background, so it only needs
+  // the background and the forms (the rest of the project is not used)
+  Project project;
+  project.source = getExportBackground();
+  project.forms  = _forms;
+  const int scale = _fileConfig.exportScale;
+
+  logUser(LOG_TEXT, "", "Rendering the image at %dx (%dx%d pixels)", scale, area.width() * scale, area.height() * scale);
+
+  ImageExporter *exporter = _exporter;
+  if (toImage) {
+     const QString path = getFilePath(FILE_IMAGE);
+     _pendingExports.append(path);
+
+     QMetaObject::invokeMethod(exporter, [exporter, project, area, scale, path]() {
+       exporter->saveScaledImage(project, area, scale, path);
+     }, Qt::QueuedConnection);
+     return;
+  }
+
+#ifdef Q_OS_LINUX
+  const QString format = _fileConfig.clipboardExt;
+  const int quality    = (format == "png") ? CLIPBOARD_PNG_QUALITY : -1;
+
+  QMetaObject::invokeMethod(exporter, [exporter, project, area, scale, format, quality]() {
+    exporter->encodeScaledImage(project, area, scale, format, quality);
+  }, Qt::QueuedConnection);
+#else
+  // QClipboard needs the whole image
+  if (!_clipboard) {
+   logUser(LOG_ERROR, "", "There's no clipboard to save the image into");
+   return;
+  }
+
+  _clipboard->setImage(renderScaledImage(project, area, scale));
+  logUser(LOG_SUCCESS, "", "Image saved to clipboard successfully!");
+  QApplication::beep();
+#endif
+}
+
+void ZoomWidget::pipeToClipboard(const QByteArray bytes, const QString format)
+{
+  if (bytes.isEmpty()) {
+    logUser(LOG_ERROR, "", "Couldn't encode the image for the clipboard");
+    return;
+  }
+
+  const QString mimeType = "image/" + format;
+
+  QString appName;
+  QList<QString> procArgs;
+  if (QGuiApplication::platformName() == QString("wayland")) {
+    appName = "wl-copy";
+    procArgs << "--type" << mimeType;
+  } else { // X11
+    appName = "xclip";
+    // Without the '-i' file, it reads the image from the standard input
+    procArgs << "-selection" << "clipboard"
+             << "-target"    << mimeType;
+  }
+
+  // The process is not awaited. Its result is handled in the following
+  // callbacks, and it's deleted once it finished
+  QProcess *process = new QProcess(this);
+  process->setProgram(appName);
+  process->setArguments(procArgs);
+  process->setProcessChannelMode(QProcess::ForwardedChannels);
+
+  connect(process, &QProcess::started, this, [process, bytes]() {
+    process->write(bytes);
+    process->closeWriteChannel();
+  });
+
+  connect(process, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+    // The other errors are handled when the process finishes
+    if (error != QProcess::FailedToStart) {
+      return;
+    }
+
+    logUser(LOG_ERROR, "", "Couldn't start %s, maybe is not installed...", QSTRING_TO_STRING(appName));
+    logUser(LOG_TEXT, "", "  - Error: %s", QSTRING_TO_STRING(process->errorString()));
+    logUser(LOG_TEXT, "", "  - Executed command: %s %s", QSTRING_TO_STRING(process->program()), QSTRING_TO_STRING(process->arguments().join(" ")));
+    copyToClipboardWithQt(bytes, mimeType);
+    process->deleteLater();
+  });
+
+  connect(process, &QProcess::finished, this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
+    if (exitStatus == QProcess::CrashExit) {
+      logUser(LOG_ERROR, "", "%s crashed", QSTRING_TO_STRING(appName));
+      copyToClipboardWithQt(bytes, mimeType);
+    } else if (exitCode != 0) {
+      logUser(LOG_ERROR, "", "%s failed. Exit code: %d", QSTRING_TO_STRING(appName), exitCode);
+      copyToClipboardWithQt(bytes, mimeType);
+    } else {
+      logUser(LOG_SUCCESS, "","Saving image to clipboard with %s was successful!", QSTRING_TO_STRING(appName));
+      QApplication::beep();
+    }
+
+    process->deleteLater();
+  });
+
+  logUser(LOG_TEXT, "", "Trying to save the image to the clipboard with %s...", QSTRING_TO_STRING(appName));
+  process->start();
+}
+
+// If there's an error with 'xclip' or 'wl-copy', copy the image with Qt.
+// Some clipboard managers will lose the image when ZoomMe exits, because the
+// clipboard only saves a pointer to that image
+void ZoomWidget::copyToClipboardWithQt(const QByteArray bytes, const QString mimeType)
+{
+  if (!_clipboard) {
+   logUser(LOG_ERROR, "", "There's no clipboard to save the image into");
+   return;
+  }
+
+  logUser(LOG_TEXT, "", "Saving the image to the clipboard with Qt");
+  QMimeData *mimeData = new QMimeData();
+  mimeData->setData(mimeType, bytes);
+  _clipboard->setMimeData(mimeData);
+  logUser(LOG_SUCCESS, "", "Image saved to clipboard successfully! (it may be lost when ZoomMe exits)");
+  QApplication::beep();
+}
+
+void ZoomWidget::imageExported(const QString path, const bool success)
+{
+  _pendingExports.removeOne(path);
+
+  if (path == STDIO_PATH) {
+    if (!success) {
+      logUser(LOG_ERROR_AND_EXIT, "", "Couldn't write the image in the standard output");
+    }
+    emit quitRequested();
+    return;
+  }
+
+  if (success) {
+    QApplication::beep();
+    logUser(LOG_SUCCESS, "Image saved correctly!", "Image saved correctly: %s", QSTRING_TO_STRING(path));
+  } else {
+    logUser(LOG_ERROR, "", "Couldn't save the picture to: %s", QSTRING_TO_STRING(path));
+  }
+}
+
+void ZoomWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+  // The cursor pos is relative to the resolution of scaled monitor
+  const QPoint cursorPos = event->pos();
 
   // Pre mouse processing
   if (_state == STATE_TRIMMING) {
@@ -2749,8 +2709,7 @@ void ZoomWidget::mouseReleaseEvent(QMouseEvent *event)
     const QPoint e = _endDrawPoint;
 
     QRect trimSize = fixQRect(s.x(), s.y(), e.x() - s.x(), e.y() - s.y());
-    QPixmap trimmed = _canvas.pixmap.copy(trimSize);
-    saveImage(trimmed, (_trimDestination == TRIM_SAVE_TO_IMAGE) ? true : false);
+    saveImage(trimSize, (_trimDestination == TRIM_SAVE_TO_IMAGE) ? true : false);
 
     _state = STATE_NORMAL;
     updateCursorShape();
@@ -2829,7 +2788,26 @@ void ZoomWidget::mouseReleaseEvent(QMouseEvent *event)
     // The registration of the points of the FreeForms are in
     // mouseMoveEvent(). This function indicates that the drawing is no
     // longer being actively drawn, and saves the current state to it
-    data.points = _forms.takeLast().points;
+    flushFreeFormSamples();
+    setPointerEventsCompressed(true);
+    // The smoothed points lag behind the pointer, so the form ends where it was
+    // released
+    QList<QPoint> &points = _forms.last().points;
+    const QPoint releasePoint = inverseViewTransform().map(event->position()).toPoint();
+    if (points.last() != releasePoint) {
+      points.append(releasePoint);
+      _forms.last().penWidths.append(getFreeFormWidth(_strokeFilter.speed()));
+    }
+    const Form freeForm = _forms.takeLast();
+    data.points = freeForm.points;
+    data.penWidths = freeForm.penWidths;
+
+    // The slow strokes have a lot of points that are almost in a line. The
+    // tolerance is in the screen, so it's smaller in the pixmap when zoomed in
+    const int drawnPoints = data.points.size();
+    const qreal tolerance = FIX_X_FOR_HDPI_SCALING(FREEFORM_SIMPLIFY_TOLERANCE / _canvas.scale);
+    const int savedPoints = simplifyStroke(&data.points, &data.penWidths, tolerance);
+    qCDebug(strokeLog, "Free form saved with %d of its %d points", savedPoints, drawnPoints);
 
     // If the free form is just a point
     if (data.points.size() == 1) {
@@ -2838,10 +2816,9 @@ void ZoomWidget::mouseReleaseEvent(QMouseEvent *event)
       return;
     }
 
-    for (int i=0; i<FREEFORM_SMOOTHING; i++) {
-      data = smoothFreeForm(data);
+    if (!_highlight) {
+      data.outline = freeFormOutline(data);
     }
-    data.penWidths.append(getFreeFormWidth(data));
   }
 
   _forms.append(data);
@@ -2859,13 +2836,6 @@ void ZoomWidget::updateCursorShape()
   QCursor appDefault    = QCursor(Qt::CrossCursor);
   QCursor normal        = QCursor(Qt::ArrowCursor);
 
-  // Pick color
-  QPixmap pickColorPixmap(":/resources/color-picker/16.png");
-  if (pickColorPixmap.isNull()) {
-    logUser(LOG_ERROR, "", "Failed to load pixmap for the color-picker cursor");
-  }
-  QCursor pickColor = QCursor(pickColorPixmap, 0, pickColorPixmap.height()-1);
-
   QPoint cursorPos = GET_CURSOR_POS();
 
   if (IS_FFMPEG_RUNNING) {
@@ -2889,7 +2859,7 @@ void ZoomWidget::updateCursorShape()
     setCursor(blank);
 
   } else if (_state == STATE_COLOR_PICKER) {
-    setCursor(pickColor);
+    setCursor(_pickColorCursor);
 
   } else if (_state == STATE_DELETING) {
     setCursor(pointHand);
@@ -2912,6 +2882,31 @@ void ZoomWidget::mouseMoveEvent(QMouseEvent *event)
   const QPoint cursorPos   = event->pos();
   const bool buttonPressed = (event->buttons() != Qt::NoButton);
 
+  // While a free form is drawn, the events aren't compressed (see
+  // setPointerEventsCompressed()), so each one only moves the canvas (the
+  // sample is mapped with it) and adds its sample. The rest (the focus, the
+  // cursor and the repaint) is done once for all the events that arrived
+  // together, with the last position
+  if (_state == STATE_DRAWING && _drawMode == FREEFORM && buttonPressed && !_canvas.dragging &&
+      _screenOpts != SCREENOPTS_HIDE_ALL && !isCursorOverToolBar(cursorPos)) {
+    if (!isDisabledMouseTracking()) {
+      shiftPixmap(cursorPos);
+    }
+
+    // The samples of the pen arrive in tabletEvent() (and these events are
+    // made from them)
+    if (!_tabletStroke) {
+      queueFreeFormSample(event->position(), event->timestamp());
+    }
+
+    _strokeMousePos = cursorPos;
+    if (!_strokeMoveQueued) {
+      _strokeMoveQueued = true;
+      QTimer::singleShot(0, this, &ZoomWidget::finishStrokeMove);
+    }
+    return;
+  }
+
   // If the app lost focus, request it again
   if (!QWidget::isActiveWindow()) {
     QWidget::activateWindow();
@@ -2941,30 +2936,147 @@ void ZoomWidget::mouseMoveEvent(QMouseEvent *event)
     goto exit;
   }
 
-  // Register the position of the cursor for the FreeForm
-  if (_state == STATE_DRAWING && _drawMode == FREEFORM) {
-    // If the user moves the mouse out of ZoomMe and releases the mouse button,
-    // the free form will be left opened. This finishes the form
-    if (!buttonPressed) {
-      mouseReleaseEvent(event);
-      return;
+  // If the user moves the mouse out of ZoomMe and releases the mouse button,
+  // the free form will be left opened. This finishes the form
+  if (_state == STATE_DRAWING && _drawMode == FREEFORM && !buttonPressed) {
+    mouseReleaseEvent(event);
+    return;
+  }
+
+exit:
+  updateAfterMouseMove(cursorPos);
+}
+
+void ZoomWidget::finishStrokeMove()
+{
+  _strokeMoveQueued = false;
+
+  if (!QWidget::isActiveWindow()) {
+    QWidget::activateWindow();
+  }
+  updateCursorShape();
+  updateAfterMouseMove(_strokeMousePos);
+}
+
+void ZoomWidget::updateAfterMouseMove(const QPoint cursorPos)
+{
+  if (_liveMode && _canvas.scale > 1.0f) {
+    // The magnified area moved, so capture it soon (or when the mouse stops,
+    // if the window has to be hidden to capture it)
+    _liveZoomLastMove = QDateTime::currentMSecsSinceEpoch();
+    if (_liveZoomHidesWindow) {
+      _liveZoomTimer->start(LIVE_ZOOM_IDLE_TIME);
+    } else if (_liveZoomTimer->isActive() && _liveZoomTimer->remainingTime() > LIVE_ZOOM_FAST_INTERVAL) {
+      _liveZoomTimer->start(LIVE_ZOOM_FAST_INTERVAL);
     }
+    update();
+  } else if (_liveMode) {
+    updateLiveRegion(cursorPos);
+  } else {
+    update();
+  }
+  _lastMousePos = cursorPos;
+}
 
-    const QPoint cursorInPixmap = screenPointToPixmapPos(cursorPos);
+void ZoomWidget::setPointerEventsCompressed(const bool compressed)
+{
+  // Every position of the pointer is delivered while drawing a free form
+  // (instead of only the last one before each frame), so it doesn't skip parts
+  // of fast strokes. Otherwise, they're compressed, so hovering doesn't process
+  // every event
+  QApplication::setAttribute(Qt::AA_CompressHighFrequencyEvents, compressed);
+  QApplication::setAttribute(Qt::AA_CompressTabletEvents, compressed);
+}
 
-    // It's not empty and the last is active
-    if (_forms.last().points.last() != cursorInPixmap) {
-      Form f = _forms.takeLast();
-      f.points.append(cursorInPixmap);
-      _forms.append(f);
+void ZoomWidget::tabletEvent(QTabletEvent *event)
+{
+  // The pen reports more positions (and more precise) than the mouse events
+  // that are made from it, so they're used while drawing a free form. The event
+  // is ignored, so the mouse event still arrives to move the canvas, change
+  // the cursor and finish the form
+  if (event->type() == QEvent::TabletMove && _state == STATE_DRAWING && _drawMode == FREEFORM) {
+    // The mouse event of this position moves the canvas after this, so it's
+    // moved now (it only depends on the position of the cursor)
+    if (!isDisabledMouseTracking()) {
+      shiftPixmap(event->position().toPoint());
     }
 
-    goto exit;
+    _tabletStroke = true;
+    queueFreeFormSample(event->position(), event->timestamp());
   }
 
-exit:
-  _lastMousePos = cursorPos;
-  update();
+  event->ignore();
+}
+
+void ZoomWidget::queueFreeFormSample(const QPointF pos, const qint64 time)
+{
+  // Same as screenPointToPixmapPos(), without rounding, so the filter keeps
+  // the precision of the samples
+  _pendingSamples.append(PointerSample{inverseViewTransform().map(pos), time});
+}
+
+void ZoomWidget::flushFreeFormSamples()
+{
+  if (_pendingSamples.isEmpty()) {
+    return;
+  }
+
+  const bool drawingFreeForm = _state == STATE_DRAWING && _drawMode == FREEFORM &&
+                               !_forms.isEmpty() && _forms.last().active && _forms.last().type == FREEFORM;
+  if (drawingFreeForm) {
+    QList<QPoint> &points = _forms.last().points;
+    for (int i=0; i<_pendingSamples.size(); i++) {
+      const PointerSample &sample = _pendingSamples.at(i);
+
+      const QPoint point = _strokeFilter.filter(sample.pos, sample.time).toPoint();
+      if (points.last() != point) {
+        points.append(point);
+        _forms.last().penWidths.append(getFreeFormWidth(_strokeFilter.speed()));
+      }
+    }
+  }
+
+  _pendingSamples.clear();
+}
+
+void ZoomWidget::updateLiveRegion(const QPoint cursorPos)
+{
+  // The other states and modes can change anything in the window (like the
+  // hovered forms, the flashlight or the pixmap used to record), so the whole
+  // window is repainted
+  const bool tracked = (_state == STATE_DRAWING || (_state == STATE_NORMAL && _drawMode != TEXT))
+                       && !_flashlightMode && !IS_RECORDING;
+  if (!tracked) {
+    update();
+    return;
+  }
+
+  // The status box hides when the cursor is near, and the buttons of the tool
+  // bar change when hovered
+  QRegion damage(_statusRect);
+  if (isToolBarVisible()) {
+    damage += _toolBar.rect.adjusted(-_toolBar.margin, -_toolBar.margin, _toolBar.margin, _toolBar.margin);
+  }
+
+  // The active form, where it was and where it is now. The margin covers the
+  // width of the pen, the highlight and the arrow head
+  if (_state == STATE_DRAWING) {
+    const int margin = _activePen.width() * 4 + MAX_ARROWHEAD_LENGTH;
+    if (_drawMode == FREEFORM) {
+      damage += QRect(_lastMousePos, cursorPos).normalized().adjusted(-margin, -margin, margin, margin);
+      // The smoothed form lags behind the cursor, so it continues from its
+      // last point
+      if (!_forms.isEmpty() && _forms.last().active && _forms.last().type == FREEFORM) {
+        const QPoint lastPoint = pixmapPointToScreenPos(_forms.last().points.last());
+        damage += QRect(lastPoint, cursorPos).normalized().adjusted(-margin, -margin, margin, margin);
+      }
+    } else {
+      damage += QRect(_startDrawPoint, _lastMousePos).normalized().adjusted(-margin, -margin, margin, margin);
+      damage += QRect(_startDrawPoint, cursorPos).normalized().adjusted(-margin, -margin, margin, margin);
+    }
+  }
+
+  update(damage);
 }
 
 // The mouse pos shouldn't be fixed to the hdpi scaling
@@ -2989,7 +3101,7 @@ void ZoomWidget::updateAtMousePos(const QPoint mousePos)
 
 void ZoomWidget::wheelEvent(QWheelEvent *event)
 {
-  if (_state == STATE_DRAWING || _state == STATE_TYPING) {
+  if (_state == STATE_DRAWING || _state == STATE_TYPING || _loadingClipboard) {
     return;
   }
 
@@ -3007,14 +3119,104 @@ void ZoomWidget::wheelEvent(QWheelEvent *event)
     return;
   }
 
+  _canvas.scale *= 1 + sign * SCALE_SENSIVITY;
+
+  // In live mode, the desktop can't be shown smaller than it is
+  if (_liveMode && _canvas.scale < 1.0f) {
+    _canvas.scale = 1.0f;
+  }
+
+  scalePixmapAt(GET_CURSOR_POS());
+
   if (_liveMode) {
+    updateLiveZoom();
+  }
+
+  update();
+}
+
+void ZoomWidget::updateLiveZoom()
+{
+  if (_canvas.scale > 1.0f) {
+    if (_liveZoomHidesWindow) {
+      // Once the zoom stops changing (see captureLiveZoom())
+      _liveZoomTimer->start(LIVE_ZOOM_IDLE_TIME);
+    } else if (!_liveZoomTimer->isActive() && !_liveZoomCapturing) {
+      captureLiveZoom();
+    }
     return;
   }
 
-  _canvas.scale *= 1 + sign * SCALE_SENSIVITY;
+  // Back to the normal live mode (the forms over the real desktop)
+  _liveZoomTimer->stop();
+  stopScreenCapture();
+  _canvas.source.fill(Qt::transparent);
+}
 
-  scalePixmapAt(GET_CURSOR_POS());
+void ZoomWidget::captureLiveZoom()
+{
+  if (_canvas.scale <= 1.0f || _liveZoomCapturing) {
+    return;
+  }
+
+  // In live mode, the pixmap has the size of the screen (in its real pixels),
+  // so this is the region of the screen under the magnified area
+  const QRect region = QRect(screenPointToPixmapPos(QPoint(0, 0)),
+                             screenPointToPixmapPos(QPoint(width(), height())))
+                         .normalized()
+                         .intersected(_canvas.source.rect());
+  if (region.isEmpty()) {
+    return;
+  }
+
+#ifdef Q_OS_WIN
+  drawLiveZoomCapture(region, grabScreenRegion(region));
+#else
+  const QImage capture = grabScreenUnderWindow(_desktopScreen, this, region);
+  if (!capture.isNull()) {
+    drawLiveZoomCapture(region, QPixmap::fromImage(capture));
+  } else {
+    // The window has to be hidden, so the capture doesn't contain the
+    // magnified desktop. It blinks, so it's only captured when the mouse stops
+    // (see mouseMoveEvent()), and it isn't captured again until it moves
+    _liveZoomHidesWindow = true;
+    _liveZoomCapturing = true;
+    setWindowOpacity(0.0);
+    QTimer::singleShot(LIVE_ZOOM_HIDE_DELAY, this, [this, region]() {
+      drawLiveZoomCapture(region, grabScreenRegion(region));
+      setWindowOpacity(1.0);
+      _liveZoomCapturing = false;
+    });
+    return;
+  }
+#endif
+
+  // Faster while the user is moving around
+  const bool idle = QDateTime::currentMSecsSinceEpoch() - _liveZoomLastMove > LIVE_ZOOM_IDLE_TIME;
+  _liveZoomTimer->start(idle ? LIVE_ZOOM_SLOW_INTERVAL : LIVE_ZOOM_FAST_INTERVAL);
+}
 
+QPixmap ZoomWidget::grabScreenRegion(const QRect region)
+{
+  // The screen is grabbed in its coordinates (not fixed to HDPI scaling), and
+  // the grab has its real pixels
+  return _desktopScreen->grabWindow(0, GET_X_FROM_HDPI_SCALING(region.x()), GET_Y_FROM_HDPI_SCALING(region.y()),
+                                    GET_X_FROM_HDPI_SCALING(region.width()), GET_Y_FROM_HDPI_SCALING(region.height()));
+}
+
+void ZoomWidget::drawLiveZoomCapture(const QRect region, QPixmap capture)
+{
+  if (capture.isNull() || _canvas.scale <= 1.0f) {
+    return;
+  }
+
+  // The capture is copied pixel by pixel (the source has the real resolution
+  // of the screen too)
+  capture.setDevicePixelRatio(1.0);
+  QPainter painter(&_canvas.source);
+  painter.setCompositionMode(QPainter::CompositionMode_Source);
+  painter.drawPixmap(region, capture);
+  painter.end();
   update();
 }
 
@@ -3044,12 +3246,12 @@ QString ZoomWidget::getFilePath(const FileType type)
     filePath = _fileConfig.folder.absoluteFilePath(fileName);
 
     fileIndex++;
-  } while (QFile(filePath).exists());
+  } while (QFile(filePath).exists() || _pendingExports.contains(filePath));
 
   return filePath;
 }
 
-void ZoomWidget::initFileConfig(const QString path, const QString name, const QString imgExt, const QString vidExt)
+void ZoomWidget::initFileConfig(const QString path, const QString name, const QString imgExt, const QString vidExt, const QString clipExt, const int scale)
 {
   // Path
   if (path.isEmpty()) {
@@ -3066,8 +3268,7 @@ void ZoomWidget::initFileConfig(const QString path, const QString name, const QS
   _fileConfig.name = name;
 
   // Check if image extension is supported
-  QList supportedExtensions = QImageWriter::supportedImageFormats();
-  if (!imgExt.isEmpty() && !supportedExtensions.contains(imgExt)) {
+  if (!imgExt.isEmpty() && !isImageFormatSupported(imgExt)) {
     logUser(LOG_ERROR_AND_EXIT, "", "Image extension not supported");
   }
 
@@ -3078,6 +3279,18 @@ void ZoomWidget::initFileConfig(const QString path, const QString name, const QS
   _fileConfig.videoExt = (vidExt.isEmpty()) ? defaultVidExt : vidExt;
   const char* defaultZoommeExt = "zoomme";
   _fileConfig.zoommeExt = defaultZoommeExt;
+
+  // Format of the images copied to the clipboard
+  if (!clipExt.isEmpty() && clipExt != "png" && clipExt != "bmp") {
+    logUser(LOG_ERROR_AND_EXIT, "", "Clipboard image format not supported (use 'png' or 'bmp')");
+  }
+  _fileConfig.clipboardExt = (clipExt.isEmpty()) ? CLIPBOARD_FORMAT : clipExt;
+
+  // Scale
+  if (scale < 1) {
+    logUser(LOG_ERROR_AND_EXIT, "", "The scale of the exported images should be a positive number");
+  }
+  _fileConfig.exportScale = scale;
 }
 
 // The cursor pos should be fixed to the hdpi scaling if the x, y, width and
@@ -3105,62 +3318,20 @@ bool ZoomWidget::isCursorInsideHitBox(int x, int y, int w, int h, const QPoint c
   return hitBox.contains(cursorPos);
 }
 
-bool ZoomWidget::isCursorOverLine(int x, int y, int w, int h, const QPoint cursorPos)
+bool ZoomWidget::isCursorOverLines(const QList<QPoint> &points, const int penWidth, const QPoint cursorPos)
 {
-  const int segmentSize = 25; // Segment size for the hypotenuse
-
-  // Divide the line in chunks (depending of the line size)
-  int chunkCount = std::hypot(w / _canvas.scale, h / _canvas.scale) / segmentSize;
-  if (chunkCount == 0) chunkCount = 1;
+  // The distance is the same in the screen at any zoom, so it's smaller in the
+  // pixmap when zoomed in
+  const qreal distance = penWidth / 2.0 + FIX_X_FOR_HDPI_SCALING(HOVER_DISTANCE / _canvas.scale);
 
-  const QSizeF chunkSize(
-        (float)w / (float)chunkCount,
-        (float)h / (float)chunkCount
-      );
-
-  for (int i=0; i<chunkCount; i++) {
-    if (isCursorInsideHitBox(
-          x + chunkSize.width() * i,
-          y + chunkSize.height() * i,
-          chunkSize.width(),
-          chunkSize.height(),
-          cursorPos,
-          false)
-       ) {
-      return true;
-    }
-  }
-  return false;
+  return isNearPolyline(points.constData(), points.size(), screenPointToPixmapPos(cursorPos), distance);
 }
 
-bool ZoomWidget::isCursorOverArrowHead(ArrowHead head, const QPoint cursorPos)
+bool ZoomWidget::isCursorOverArrowHead(const ArrowHead head, const int penWidth, const QPoint cursorPos)
 {
-  // Convert the pixmap points of the arrow to screen points
-  head.startPoint   = pixmapPointToScreenPos(head.startPoint);
-  head.leftLineEnd  = pixmapPointToScreenPos(head.leftLineEnd);
-  head.rightLineEnd = pixmapPointToScreenPos(head.rightLineEnd);
-    // Left Line check
-  if (isCursorOverLine(
-         head.startPoint.x(),
-         head.startPoint.y(),
-         head.leftLineEnd.x() - head.startPoint.x(),
-         head.leftLineEnd.y() - head.startPoint.y(),
-         cursorPos)
-     ) {
-      return true;
-  }
-    // Right Line check
-  if (isCursorOverLine(
-         head.startPoint.x(),
-         head.startPoint.y(),
-         head.rightLineEnd.x() - head.startPoint.x(),
-         head.rightLineEnd.y() - head.startPoint.y(),
-         cursorPos)
-     ) {
-      return true;
-  }
-
-  return false;
+  // Both lines of the head, as a single polyline
+  const QList<QPoint> lines = { head.leftLineEnd, head.startPoint, head.rightLineEnd };
+  return isCursorOverLines(lines, penWidth, cursorPos);
 }
 
 // The cursor pos shouln't be fixed to hdpi scaling, because in
@@ -3171,13 +3342,12 @@ int ZoomWidget::cursorOverForm(const QPoint cursorPos)
 {
   int x, y, w, h;
   for (int i=0; i<_forms.size(); i++) {
-    Form f = _forms.at(i);
+    const Form &f = _forms.at(i);
 
     if (!f.deleted && f.type==_drawMode) {
       switch (f.type) {
         case LINE:
-          getSimpleFormPosition(f, &x, &y, &w, &h, true);
-          if (isCursorOverLine(x, y, w, h, cursorPos)) {
+          if (isCursorOverLines(f.points, f.pen.width(), cursorPos)) {
             return i;
           }
 
@@ -3186,7 +3356,7 @@ int ZoomWidget::cursorOverForm(const QPoint cursorPos)
           if (f.arrow) {
             getSimpleFormPosition(f, &x, &y, &w, &h, false);
             ArrowHead head = getArrowHead(x, y, w, h, 0);
-            if (isCursorOverArrowHead(head, cursorPos)) return i;
+            if (isCursorOverArrowHead(head, f.pen.width(), cursorPos)) return i;
           }
           break;
 
@@ -3207,26 +3377,18 @@ int ZoomWidget::cursorOverForm(const QPoint cursorPos)
               return i;
             }
           } else {
-            for (int z = 0; z < f.points.size()-1; ++z) {
-              QPoint current = f.points.at(z);
-              QPoint next    = f.points.at(z+1);
-
-              current = pixmapPointToScreenPos(current);
-              next = pixmapPointToScreenPos(next);
-
-              x = current.x();
-              y = current.y();
-              w = next.x() - x;
-              h = next.y() - y;
+            // The widest segment (with the dynamic width, they can be wider
+            // than the pen)
+            int width = f.pen.width();
+            for (int z=0; z<f.penWidths.size(); z++) width = qMax(width, f.penWidths.at(z));
 
-              if (isCursorInsideHitBox(x, y, w, h, cursorPos, false)) {
-                return i;
-              }
+            if (isCursorOverLines(f.points, width, cursorPos)) {
+              return i;
             }
 
             if (f.arrow) {
               ArrowHead head = getFreeFormArrowHead(f);
-              if (isCursorOverArrowHead(head, cursorPos)) return i;
+              if (isCursorOverArrowHead(head, f.pen.width(), cursorPos)) return i;
             }
           }
           break;
@@ -3412,24 +3574,127 @@ void ZoomWidget::setLiveMode()
 {
   _liveMode = true;
 
-  QPixmap desktop = _desktopScreen->grabWindow(0);
-
-  _canvas.source = QPixmap(_windowSize);
+  // The pixmap has the real resolution of the screen (like the desktop grabs),
+  // so the captures of the zoom (see captureLiveZoom()) aren't scaled down
+  _canvas.source = QPixmap(_windowSize * _desktopScreen->devicePixelRatio());
   _canvas.source.fill(Qt::transparent);
+
+#ifdef Q_OS_WIN
+  // The window is excluded from the captures of the zoom (see
+  // captureLiveZoom()), so it doesn't need to be hidden
+  SetWindowDisplayAffinity((HWND) winId(), WDA_EXCLUDEFROMCAPTURE);
+#endif
 }
 
-void ZoomWidget::grabFromClipboard()
+QString ZoomWidget::grabFromClipboard()
 {
   if (!_clipboard) {
-    logUser(LOG_ERROR_AND_EXIT, "", "The clipboard is uninitialized");
+    return "The clipboard is uninitialized";
+  }
+
+  // Only the list of formats is asked now (QClipboard::image() would fetch
+  // and decode the image, usually a big PNG, before showing the window)
+  const QMimeData *mimeData = _clipboard->mimeData();
+  const QString mimeType = (mimeData) ? clipboardImageFormat(mimeData->formats()) : QString();
+  if (mimeType.isEmpty()) {
+    return "The clipboard doesn't contain an image or its format is not supported";
   }
 
-  QImage image = _clipboard->image();
-  if (image.isNull()) {
-    logUser(LOG_ERROR_AND_EXIT, "", "The clipboard doesn't contain an image or its format is not supported");
+  // Placeholder with the size of the screen until the image arrives
+  _loadingClipboard = true;
+  createBlackboard(_windowSize);
+  fetchClipboardImage(mimeType);
+  return QString();
+}
+
+void ZoomWidget::fetchClipboardImage(const QString mimeType)
+{
+  logUser(LOG_TEXT, "", "Loading the image of the clipboard (%s)", QSTRING_TO_STRING(mimeType));
+
+#ifdef Q_OS_LINUX
+  // The image is read by another process, so the GUI thread doesn't wait for
+  // the owner of the clipboard to send it
+  QString appName;
+  QList<QString> procArgs;
+  if (QGuiApplication::platformName() == QString("wayland")) {
+    appName = "wl-paste";
+    procArgs << "--no-newline" << "--type" << mimeType;
+  } else { // X11
+    appName = "xclip";
+    procArgs << "-selection" << "clipboard"
+             << "-target"    << mimeType
+             << "-o";
   }
 
-  grabImage(QPixmap::fromImage(image));
+  QProcess *process = new QProcess(this);
+  process->setProgram(appName);
+  process->setArguments(procArgs);
+  process->setProcessChannelMode(QProcess::SeparateChannels);
+
+  connect(process, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+    // The other errors are handled when the process finishes
+    if (error != QProcess::FailedToStart) {
+      return;
+    }
+
+    logUser(LOG_ERROR, "", "Couldn't start %s, maybe is not installed. Loading the image with Qt...", QSTRING_TO_STRING(appName));
+    decodeClipboardImage(readClipboardData(mimeType));
+    process->deleteLater();
+  });
+
+  connect(process, &QProcess::finished, this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
+    if (exitStatus == QProcess::NormalExit && exitCode == 0) {
+      decodeClipboardImage(process->readAllStandardOutput());
+    } else {
+      logUser(LOG_ERROR, "", "%s failed. Loading the image with Qt...", QSTRING_TO_STRING(appName));
+      decodeClipboardImage(readClipboardData(mimeType));
+    }
+
+    process->deleteLater();
+  });
+
+  process->start();
+#else
+  decodeClipboardImage(readClipboardData(mimeType));
+#endif
+}
+
+QByteArray ZoomWidget::readClipboardData(const QString mimeType)
+{
+  // The clipboard can change (or be emptied) while it's loading
+  const QMimeData *mimeData = _clipboard->mimeData();
+  return (mimeData) ? mimeData->data(mimeType) : QByteArray();
+}
+
+void ZoomWidget::decodeClipboardImage(const QByteArray bytes)
+{
+  QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+
+  connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher]() {
+    const QImage image = watcher->result();
+    watcher->deleteLater();
+    _loadingClipboard = false;
+
+    // The user closed the window while it was loading
+    if (!isVisible()) {
+      return;
+    }
+
+    // The clipboard changed since its formats were checked. The placeholder is
+    // left as an empty blackboard (and the daemon keeps running)
+    if (image.isNull()) {
+      logUser(LOG_ERROR, "", "Couldn't load the image of the clipboard (it changed or its format is not supported)");
+      update();
+      return;
+    }
+
+    grabImage(QPixmap::fromImage(image));
+    update();
+  });
+
+  watcher->setFuture(QtConcurrent::run([bytes]() {
+    return QImage::fromData(bytes);
+  }));
 }
 
 void ZoomWidget::createBlackboard(const QSize size)
@@ -3442,30 +3707,90 @@ void ZoomWidget::createBlackboard(const QSize size)
   showFullScreen();
 }
 
-void ZoomWidget::grabDesktop()
+// The desktop pixmap is null if it couldn't capture the screenshot. For
+// example, in Wayland, it will be null because Wayland doesn't support screen
+// grabbing
+static QString grabDesktopError()
 {
-  QPixmap desktop = _desktopScreen->grabWindow(0);
+  return (QGuiApplication::platformName() == QString("wayland"))
+         ? "Couldn't grab the desktop. It seems you're using Wayland: try to use the '-l' flag (live mode)"
+         : "Couldn't grab the desktop";
+}
+
+QString ZoomWidget::grabDesktop()
+{
+  if (!_desktopScreen) {
+    return "There isn't any screen to grab";
+  }
 
-  // The desktop pixmap is null if it couldn't capture the screenshot. For
-  // example, in Wayland, it will be null because Wayland doesn't support screen
-  // grabbing
+  QPixmap desktop = _desktopScreen->grabWindow(0);
   if (desktop.isNull()) {
-    const char* message = (QGuiApplication::platformName() == QString("wayland"))
-                          ? "Couldn't grab the desktop. It seems you're using Wayland: try to use the '-l' flag (live mode)"
-                          : "Couldn't grab the desktop";
+    return grabDesktopError();
+  }
+
+  // Fixes the issue with hdpi scaling (the size of the image is the real
+  // resolution of the screen). The grab is adopted as the source: only its
+  // device pixel ratio is reset, so the pixels aren't copied (the pixmap isn't
+  // shared, so setDevicePixelRatio() doesn't detach it)
+  desktop.setDevicePixelRatio(1.0);
+  _canvas.source = std::move(desktop);
+
+  if (!_liveMode) showFullScreen();
+  return QString();
+}
 
-    logUser(LOG_ERROR_AND_EXIT, "", message);
+QString ZoomWidget::grabAllScreens()
+{
+  if (!_desktopScreen) {
+    return "There isn't any screen to grab";
+  }
+
+  // Geometry of the virtual desktop (the union of all the screens)
+  const QList<QScreen*> screens = QGuiApplication::screens();
+  QRect virtualGeometry;
+  for (int i=0; i<screens.size(); i++) {
+    virtualGeometry = virtualGeometry.united(screens.at(i)->geometry());
+  }
+
+  // Each screen is a tile with its own pixels. Only the displayed screen keeps
+  // all of them, the others are scaled down to one pixel per point of the
+  // screen (the user sees them small, until moving there). The canvas has the
+  // pixel ratio of the displayed screen, but it's only the transparent layer
+  // of the drawings (see drawDrawnPixmap())
+  const qreal ratio = _desktopScreen->devicePixelRatio();
+  _screenTiles.clear();
+  int grabbed = 0;
+  for (int i=0; i<screens.size(); i++) {
+    QPixmap tile = screens.at(i)->grabWindow(0);
+    if (tile.isNull()) {
+      logUser(LOG_ERROR, "", "Couldn't grab the screen '%s'", QSTRING_TO_STRING(screens.at(i)->name()));
+      continue;
+    }
+
+    const QRect geometry = screens.at(i)->geometry().translated(-virtualGeometry.topLeft());
+    tile.setDevicePixelRatio(1.0);
+    if (screens.at(i) != _desktopScreen && tile.width() > geometry.width()) {
+      tile = tile.scaled(geometry.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    _screenTiles.append(ScreenTile{geometry, tile});
+    grabbed++;
   }
 
-  // Paint the desktop over _canvas.source
-  // Fixes the issue with hdpi scaling (now the size of the image is the real
-  // resolution of the screen)
-  _canvas.source = QPixmap(desktop.size());
-  QPainter painter(&_canvas.source);
-  painter.drawPixmap(0, 0, desktop.width(), desktop.height(), desktop);
-  painter.end();
+  if (grabbed == 0) {
+    return grabDesktopError();
+  }
+
+  _canvas.source = QPixmap(virtualGeometry.size() * ratio);
+  _canvas.source.fill(Qt::transparent);
+
+  // One pixel of the canvas (at zoom 1) is one pixel of the displayed screen,
+  // and it starts showing the displayed screen
+  _canvas.size = virtualGeometry.size();
+  _canvas.originalSize = _canvas.size;
+  _canvas.pos = virtualGeometry.topLeft() - _desktopScreen->geometry().topLeft();
 
   if (!_liveMode) showFullScreen();
+  return QString();
 }
 
 void ZoomWidget::grabImage(const QPixmap img)
@@ -3482,6 +3807,16 @@ void ZoomWidget::grabImage(const QPixmap img)
   if (!_liveMode) showFullScreen();
 }
 
+void ZoomWidget::setOutputToStdout()
+{
+  _fileConfig.toStdout = true;
+}
+
+void ZoomWidget::setImageDetail(const QString path, const QSize fullSize)
+{
+  _imageDetail.setImage(path, fullSize, _canvas.source.size());
+}
+
 void ZoomWidget::dragPixmap(const QPoint delta)
 {
   _canvas.pos += delta;
@@ -3551,30 +3886,58 @@ void ZoomWidget::scalePixmapAt(const QPointF pos)
 
 }
 
-QPoint ZoomWidget::screenPointToPixmapPos(const QPoint qpoint)
+void ZoomWidget::updateViewTransform()
 {
-  QPoint returnPoint = (qpoint - _canvas.pos.toPoint())/_canvas.scale;
+  const bool changed = _view.scale != _canvas.scale || _view.pos != _canvas.pos ||
+                       _view.sourceSize != _canvas.source.size() || _view.originalSize != _canvas.originalSize;
+  if (!changed) {
+    return;
+  }
 
-  returnPoint.setX( FIX_X_FOR_HDPI_SCALING(returnPoint.x()) );
-  returnPoint.setY( FIX_Y_FOR_HDPI_SCALING(returnPoint.y()) );
+  _view.pos          = _canvas.pos;
+  _view.scale        = _canvas.scale;
+  _view.sourceSize   = _canvas.source.size();
+  _view.originalSize = _canvas.originalSize;
 
-  return returnPoint;
+  // The pixmap is fixed to HDPI scaling, so it's scaled to the size of the
+  // screen before zooming it
+  _view.toScreen = QTransform(GET_X_FROM_HDPI_SCALING(_canvas.scale), 0,
+                              0, GET_Y_FROM_HDPI_SCALING(_canvas.scale),
+                              _canvas.pos.x(), _canvas.pos.y());
+  _view.toPixmap = _view.toScreen.inverted();
+}
+
+const QTransform &ZoomWidget::viewTransform()
+{
+  updateViewTransform();
+  return _view.toScreen;
+}
+
+const QTransform &ZoomWidget::inverseViewTransform()
+{
+  updateViewTransform();
+  return _view.toPixmap;
+}
+
+QPoint ZoomWidget::screenPointToPixmapPos(const QPoint qpoint)
+{
+  return inverseViewTransform().map(qpoint);
 }
 
 QPoint ZoomWidget::pixmapPointToScreenPos(const QPoint qpoint)
 {
-  return QPoint(
-        _canvas.pos.toPoint().x() + (GET_X_FROM_HDPI_SCALING(qpoint.x())) * _canvas.scale,
-        _canvas.pos.toPoint().y() + (GET_Y_FROM_HDPI_SCALING(qpoint.y())) * _canvas.scale
-      );
+  return viewTransform().map(qpoint);
+}
+
+QPolygon ZoomWidget::pixmapPointsToScreenPos(const QList<QPoint> &points)
+{
+  return viewTransform().map(QPolygon(points));
 }
 
 QSize ZoomWidget::pixmapSizeToScreenSize(const QSize qsize)
 {
-  return QSize(
-        GET_X_FROM_HDPI_SCALING(qsize.width() ) * _canvas.scale,
-        GET_Y_FROM_HDPI_SCALING(qsize.height()) * _canvas.scale
-      );
+  const QTransform &transform = viewTransform();
+  return QSize(qsize.width() * transform.m11(), qsize.height() * transform.m22());
 }
 
 void ZoomWidget::drawDrawnPixmap(QPainter *painter)
@@ -3584,9 +3947,34 @@ void ZoomWidget::drawDrawnPixmap(QPainter *painter)
   const int w = _canvas.size.width();
   const int h = _canvas.size.height();
 
+  if (_imageDetail.isEnabled() && !_boardMode) {
+    painter->drawPixmap(x, y, w, h, _canvas.source);
+    _imageDetail.draw(painter, QRectF(x, y, w, h), rect());
+  }
+
+  if (!_screenTiles.isEmpty() && !_boardMode) {
+    drawScreenTiles(painter, QRectF(x, y, w, h));
+  }
+
   painter->drawPixmap(x, y, w, h, _canvas.pixmap);
 }
 
+void ZoomWidget::drawScreenTiles(QPainter *painter, const QRectF canvasRect)
+{
+  const qreal scaleX = canvasRect.width()  / _canvas.originalSize.width();
+  const qreal scaleY = canvasRect.height() / _canvas.originalSize.height();
+
+  painter->save();
+  painter->setRenderHint(QPainter::SmoothPixmapTransform);
+  for (int i=0; i<_screenTiles.size(); i++) {
+    const ScreenTile &tile = _screenTiles.at(i);
+    const QRectF target(canvasRect.x() + tile.rect.x() * scaleX, canvasRect.y() + tile.rect.y() * scaleY,
+                        tile.rect.width() * scaleX, tile.rect.height() * scaleY);
+    painter->drawPixmap(target, tile.pixmap, QRectF(tile.pixmap.rect()));
+  }
+  painter->restore();
+}
+
 bool ZoomWidget::isDisabledMouseTracking()
 {
   return !_forceMouseTracking
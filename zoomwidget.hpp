@@ -6,6 +6,10 @@
 #include <QString>
 #include <QScreen>
 #include <QPen>
+#include <QCursor>
+#include <QPainterPath>
+#include <QTransform>
+#include <QPolygon>
 #include <QClipboard>
 #include <QProcess>
 #include <QTimer>
@@ -14,6 +18,12 @@
 #include <QDir>
 #include <QSize>
 #include <QPoint>
+#include <QThread>
+#include <QFuture>
+#include "exporter.hpp"
+#include "iconatlas.hpp"
+#include "imagedetail.hpp"
+#include "strokefilter.hpp"
 
 //////////////////////////////////////////// CUSTOMIZATION
 
@@ -102,15 +112,34 @@
 
 /// Recording settings
 #define RECORD_FPS 16
+/// Format of the frames saved in the temporal file: "qoi" (lossless and much
+/// faster to encode, but the file is bigger. It needs FFmpeg 5.1 or newer) or
+/// "jpeg"
+#define RECORD_FRAME_FORMAT "qoi"
 #define RECORD_FRAME_QUALITY 70 // 0-100 | This is the JPEG compression of the frame
 // This is the name for the file located in the temporal folder which is going
 // to save the frames for the video
 #define RECORD_TEMP_FILENAME "ZoomMe_video_bytes"
 
-/// This is the name for the file located in the temporal folder, which is
-/// going to save the screenshot taken in order to pass it to the Linux clipboard
-/// manager (xclip or wl-copy)
-#define CLIPBOARD_TEMP_FILENAME "zoomme_clipboard"
+/// Thumbnail embedded at the start of the '.zoomme' files (for previews)
+#define THUMBNAIL_SIZE   256   // pixels (longest side)
+#define THUMBNAIL_FORMAT "PNG"
+
+/// Format of the image passed to the Linux clipboard manager (xclip or
+/// wl-copy): "png" or "bmp" (uncompressed, faster to encode but bigger)
+#define CLIPBOARD_FORMAT "png"
+/// Compression of the PNG passed to the clipboard manager. 0-100 | The
+/// higher, the faster (less compressed). -1 uses PNG_COMPRESSION_LEVEL
+#define CLIPBOARD_PNG_QUALITY 80
+
+/// Compression level of the exported PNG images (they're encoded in parallel).
+/// 0-9 | The higher, the smaller and slower. 6 is the default of zlib
+#define PNG_COMPRESSION_LEVEL 6
+
+/// The images exported with a scale (-s flag) are rendered and encoded in bands
+/// of this amount of pixels (4 bytes each), so the memory used doesn't depend
+/// on the size of the exported image
+#define EXPORT_BAND_PIXELS (4096 * 1024)
 
 /// This is what separates the file name of the exported file and the index
 /// number when a file with the same name and extension already exist
@@ -138,17 +167,47 @@
 /// adjusting the radius of the flashlight effect
 #define SCALE_SENSIVITY 0.1f // the higher the number, the more sensitive it is
 
+/// Zoom in live mode: the part of the desktop under the magnified area is
+/// captured again periodically, faster while the mouse is moving
+#define LIVE_ZOOM_FAST_INTERVAL 40  // msec (while the mouse moves)
+#define LIVE_ZOOM_SLOW_INTERVAL 500 // msec (when the mouse is idle)
+#define LIVE_ZOOM_IDLE_TIME     300 // msec without moving the mouse to be idle
+// Time that the window is hidden before capturing, so the compositor removes
+// it from the screen. It's only hidden if it can't be excluded from the
+// captures (in Windows and in X11 with Xcomposite it isn't hidden)
+#define LIVE_ZOOM_HIDE_DELAY    16  // msec
+
 /// This is the maximum length for the lines of the arrow head
 #define MAX_ARROWHEAD_LENGTH 50 // pixels
 
+/// This is the distance from the cursor to a line (or a free form) to hover it
+#define HOVER_DISTANCE 12 // pixels of the screen
+
 /// This is the distance between the grid lines
 #define GRID_DISTANCE_X 50 // pixels (vertical grid)
 #define GRID_DISTANCE_Y 50 // pixels (horizontal grid)
 /// This is the width of the grid lines
 #define GRID_WIDTH 2 // pixels
 
-/// This is the number of iterations of the smoothing function over the free form
-#define FREEFORM_SMOOTHING 2 // 0 --> No smoothing
+/// Smoothing of the free forms while they're drawn (see strokefilter.hpp).
+/// This is the cutoff when the pointer doesn't move. Lower smooths more
+#define STROKE_FILTER_MIN_CUTOFF 2.0 // Hz
+/// This is how much the cutoff rises with the speed. Higher lags less
+#define STROKE_FILTER_BETA 0.02 // Hz per (pixel of the screen/sec)
+/// This is the cutoff of the speed itself (so a single jump doesn't disable
+/// the smoothing)
+#define STROKE_FILTER_SPEED_CUTOFF 1.0 // Hz
+
+/// This is the maximum distance from the drawn free form to the saved one
+/// (the points that don't change it more than this are removed)
+#define FREEFORM_SIMPLIFY_TOLERANCE 0.5 // pixels of the screen
+
+/// This is the width of the dynamic free forms, from the slowest to the
+/// fastest movement of the pointer
+#define DYNAMIC_WIDTH_MIN 1 // times LINE_WIDTH_SCALE
+#define DYNAMIC_WIDTH_MAX 9 // times LINE_WIDTH_SCALE
+/// This is the speed of the pointer that draws with the maximum width
+#define DYNAMIC_WIDTH_MAX_SPEED 3000 // pixels of the screen/sec
 
 /// Pop-ups settings
 #define POPUP_WIDTH     (_windowSize.width() / 4.0) // pixels
@@ -168,7 +227,7 @@
 // It will give the mouse position relative to the resolution of scaled monitor
 #define GET_CURSOR_POS() mapFromGlobal(QCursor::pos())
 
-#define GET_COLOR_UNDER_CURSOR() _canvas.pixmap.toImage().pixel( screenPointToPixmapPos(GET_CURSOR_POS()) )
+#define GET_COLOR_UNDER_CURSOR() getDrawnImage( QRect(screenPointToPixmapPos(GET_CURSOR_POS()), QSize(1, 1)) ).pixel(0, 0)
 
 // If there's no HDPI scaling, it will return the same value, because the real
 // and the scale resolution will be de same.
@@ -217,12 +276,30 @@ struct Form {
 
   // Free Forms
   QList<int> penWidths; // The pen width of each point
+  // Area covered by the free form with its widths, so it's drawn with a single
+  // fill (see freeFormOutline()). It's not saved in the project files
+  QPainterPath outline;
 
   // For text boxes
   int caretPos;
   QString text;
 };
 
+// Position of the pointer while drawing a free form, as it arrived (they're
+// added to the form once per frame, see flushFreeFormSamples())
+struct PointerSample {
+  QPointF pos; // In the pixmap (mapped when it arrives, because the canvas
+               // moves with the cursor)
+  qint64 time; // msec
+};
+
+// A screen grabbed by grabAllScreens()
+struct ScreenTile {
+  QRect rect;     // In the canvas (NOT fixed to HDPI scaling)
+  QPixmap pixmap; // With the pixel ratio of the screen if it's the displayed
+                  // one, or one pixel per point otherwise
+};
+
 struct ArrowHead {
   QPoint startPoint;
   QPoint leftLineEnd;
@@ -258,6 +335,18 @@ struct Canvas {
   float scale;
 };
 
+// Transform between the pixmap and the screen, and the values of the canvas
+// that it was computed for (see viewTransform())
+struct ViewTransform {
+  QTransform toScreen;
+  QTransform toPixmap;
+
+  QPointF pos;
+  float scale;
+  QSize sourceSize;
+  QSize originalSize;
+};
+
 struct ExportConfig {
   QDir folder;
   QString name;
@@ -265,6 +354,9 @@ struct ExportConfig {
   QString videoExt;
   QString imageExt;
   QString zoommeExt;
+  QString clipboardExt; // Format of the images copied to the clipboard
+  int exportScale; // Resolution of the exported images (times the pixmap)
+  bool toStdout; // The exported image is written in the standard output
 };
 enum FileType {
   FILE_VIDEO,
@@ -419,15 +511,39 @@ class ZoomWidget : public QWidget
 
     void setLiveMode();
 
-    void restoreStateFromFile(const QString path);
+    // Returns false if the file can't be read or it's corrupted (the state of
+    // the widget isn't changed then)
+    bool restoreStateFromFile(const QString path);
 
     // By passing an empty QString, sets the argument to the default
-    void initFileConfig(const QString path, const QString name, const QString imgExt, const QString vidExt);
-
-    void grabFromClipboard();
-    void grabDesktop();
+    void initFileConfig(const QString path, const QString name, const QString imgExt, const QString vidExt, const QString clipExt, const int scale);
+
+    // These grab functions return the error (an empty string if they worked),
+    // so the daemon can send it to the trigger instead of exiting
+    QString grabFromClipboard();
+    QString grabDesktop();
+    // Grabs all the screens into a single canvas (the virtual desktop), so the
+    // user can move between them by zooming and moving the mouse
+    QString grabAllScreens();
     void grabImage(const QPixmap img);
+    // The image of grabImage() is the preview of a bigger image, whose regions
+    // are decoded from the file when the user zooms in
+    void setImageDetail(const QString path, const QSize fullSize);
     void createBlackboard(const QSize size);
+    // The exported image is written in the standard output (instead of a file),
+    // and the app exits after writing it
+    void setOutputToStdout();
+
+    // Waits for the fonts to be registered and sets them (only the first time).
+    // It's called before the first frame, or before to pre-warm the widget
+    void applyFonts();
+
+  signals:
+    // Emitted once, when the window is visible for the first time (the things
+    // that aren't needed to show the window can be done after this)
+    void firstFramePainted();
+    // Emitted when the user exits (the owner decides whether to quit the app)
+    void quitRequested();
 
   protected:
     virtual void paintEvent(QPaintEvent *event);
@@ -435,6 +551,7 @@ class ZoomWidget : public QWidget
     virtual void mousePressEvent(QMouseEvent *event);
     virtual void mouseReleaseEvent(QMouseEvent *event);
     virtual void mouseMoveEvent(QMouseEvent *event);
+    virtual void tabletEvent(QTabletEvent *event);
 
     virtual void wheelEvent(QWheelEvent *event);
 
@@ -447,6 +564,7 @@ class ZoomWidget : public QWidget
     // System variables
     QScreen *_desktopScreen;
     QClipboard *_clipboard;
+    QCursor _pickColorCursor;
 
 
     QList<Form> _forms;
@@ -465,6 +583,7 @@ class ZoomWidget : public QWidget
     // overlays the REAL size image on the SCALED size monitor without losing
     // quality.
     Canvas _canvas;
+    ViewTransform _view;
 
 
     // STATE/CONFIG VARIABLES
@@ -479,6 +598,13 @@ class ZoomWidget : public QWidget
     FormType _drawMode;
     QPen _activePen;
     QPoint _lastMousePos;
+    QList<PointerSample> _pendingSamples; // Of the free form being drawn
+    bool _tabletStroke; // The free form is drawn with a pen (tablet)
+    // The rest of the mouse events of the free form is queued (see
+    // mouseMoveEvent()), with the last position
+    bool _strokeMoveQueued;
+    QPoint _strokeMousePos;
+    StrokeFilter _strokeFilter; // Smooths the free form while it's drawn
     // These two following points should be fixed to hdpi scaling
     QPoint _startDrawPoint;
     QPoint _endDrawPoint;
@@ -495,18 +621,39 @@ class ZoomWidget : public QWidget
     bool _highlight;
     bool _arrow;
     bool _dynamicWidth; // Dynamic pen's width for the free form
+    QFuture<void> _fontsLoading; // Registration of the fonts (in the thread pool)
+    IconAtlas _iconAtlas; // Icons of the tool bar
+    ImageDetail _imageDetail; // Full resolution regions of a huge image (-i)
+    QList<ScreenTile> _screenTiles; // The background with --all-screens
+    bool _firstFramePainted;
+    bool _loadingClipboard; // The placeholder is shown until the image arrives
+    QRect _statusRect; // Where the status box was drawn (in the screen)
 
 
     // Timer that cancels the escape after some time
     QTimer *_exitTimer;
 
+    // Zoom in live mode (see captureLiveZoom())
+    QTimer *_liveZoomTimer;
+    qint64 _liveZoomLastMove; // Last time that the mouse moved (msecs)
+    bool _liveZoomCapturing; // The window is hidden, waiting to capture
+    bool _liveZoomHidesWindow; // The desktop can't be captured under the window
+
     // Recording
     QProcess _ffmpeg;
     QTimer *_recordTimer;
     QFile *_recordTempFile;
 
+    // Exporting images in the background
+    QThread _exportThread;
+    ImageExporter *_exporter;
+    QList<QString> _pendingExports; // Paths of the images that are being saved
+
     // Drawing functions
     void drawDrawnPixmap(QPainter *painter);
+    // Draws the tiles of the screens where the canvas is (in the coordinates of
+    // the painter)
+    void drawScreenTiles(QPainter *painter, const QRectF canvasRect);
     void drawSavedForms(QPainter *pixmapPainter);
     void drawActiveForm(QPainter *painter, const bool drawToScreen);
     // Opaque the area outside the circle of the cursor
@@ -517,8 +664,6 @@ class ZoomWidget : public QWidget
     void drawStatus(QPainter *screenPainter);
     void drawToolBar(QPainter *screenPainter);
     void drawButton(QPainter *screenPainter, const Button button);
-    ArrowHead getArrowHead(const int x, const int y, const int width, const int height, int lineLength);
-    ArrowHead getFreeFormArrowHead(const Form freeForm);
     void drawTrimmed(QPainter *pixmapPainter);
     void drawPopupTray(QPainter *screenPainter);
     void drawPopup(QPainter *screenPainter, const int listPos);
@@ -563,6 +708,18 @@ class ZoomWidget : public QWidget
 
     // _canvas functions
     void updateAtMousePos(const QPoint mousePos);
+    // Repaints only the parts of the window that changed with the mouse
+    // movement, in live mode (the window is translucent, so the compositor
+    // blends again everything that is repainted)
+    void updateLiveRegion(const QPoint cursorPos);
+    // Starts or stops capturing the desktop in live mode, after the zoom
+    // changed
+    void updateLiveZoom();
+    // Captures the part of the desktop that is under the magnified area (only
+    // that region, so the cost depends on the zoom and not on the screen)
+    void captureLiveZoom();
+    QPixmap grabScreenRegion(const QRect region);
+    void drawLiveZoomCapture(const QRect region, QPixmap capture);
     void dragPixmap(const QPoint delta);
     void shiftPixmap(const QPoint cursorPos);
     void scalePixmapAt(const QPointF pos);
@@ -585,10 +742,32 @@ class ZoomWidget : public QWidget
     // The size should be fixed to HDPI scaling
     // Returns the size that is NOT fixed to HDPI scaling
     QSize pixmapSizeToScreenSize(const QSize qsize);
+    // Same as pixmapPointToScreenPos(), for all the points at once
+    QPolygon pixmapPointsToScreenPos(const QList<QPoint> &points);
+    // The transforms used by the functions above (so they can be set on a
+    // painter too). They're computed again only when the position, the scale
+    // or the size of the canvas change
+    const QTransform &viewTransform(); // From the pixmap to the screen
+    const QTransform &inverseViewTransform(); // From the screen to the pixmap
+    void updateViewTransform();
 
     // Form Functions
-    QList<int> getFreeFormWidth(const Form form);
-    Form smoothFreeForm(Form form);
+    // Width of the next segment of the free form being drawn, from the speed of
+    // the pointer (pixels of the screen/sec) when the dynamic width is enabled
+    int getFreeFormWidth(const qreal speed);
+    // Queues the position of the pointer (in the screen) for the free form
+    void queueFreeFormSample(const QPointF pos, const qint64 time);
+    // Delivers every event of the pointer (for the free forms) or compresses
+    // them (the default of Qt)
+    void setPointerEventsCompressed(const bool compressed);
+    // What each mouse event does after processing it (repaint, live zoom...).
+    // While drawing a free form, it's done once for all the events that
+    // arrived together (finishStrokeMove())
+    void updateAfterMouseMove(const QPoint cursorPos);
+    void finishStrokeMove();
+    // Adds the pending samples of the pointer to the free form being drawn
+    // (smoothed)
+    void flushFreeFormSamples();
     void removeFormBehindCursor(const QPoint cursorPos);
     bool isDrawingHovered(const int i);
     bool isTextEditable(const QPoint cursorPos);
@@ -599,8 +778,9 @@ class ZoomWidget : public QWidget
     // The X, Y, W and H arguments must be a point in the SCREEN, not in the pixmap
     // If floating is enabled, the form (the width and height) is not affected by zoom/scaling
     bool isCursorInsideHitBox(int x, int y, int w, int h, const QPoint cursorPos, const bool isFloating);
-    bool isCursorOverLine(int x, int y, int w, int h, const QPoint cursorPos);
-    bool isCursorOverArrowHead(ArrowHead head, const QPoint cursorPos);
+    // The points are in the pixmap (consecutive points are joined by a line)
+    bool isCursorOverLines(const QList<QPoint> &points, const int penWidth, const QPoint cursorPos);
+    bool isCursorOverArrowHead(const ArrowHead head, const int penWidth, const QPoint cursorPos);
     // If posRelativeToScreen is true, it will return the positon be relative to
     // the screen, if it's false, it will return the position relative to the
     // pixmap
@@ -608,8 +788,40 @@ class ZoomWidget : public QWidget
 
     // Exporting
     QString getFilePath(const FileType type);
-    // If toImage is false, the functions saves it to the clipboard
-    void saveImage(const QPixmap pixmap, const bool toImage);
+    // Saves the area of the pixmap. If toImage is false, the functions saves it
+    // to the clipboard
+    void saveImage(const QRect area, const bool toImage);
+    // Same as saveImage(), but the drawings are rendered again by the exporter
+    // at the export scale (instead of copying the pixmap)
+    void saveScaledImage(const QRect area, const bool toImage);
+    // Same as saveImage(), but the drawings are saved as vectors (when the
+    // image extension is 'svg' or 'pdf')
+    void saveVectorImage(const QRect area);
+    // Same as saveImage(), but the image is written in the standard output and
+    // the app exits when it's written
+    void saveToStdout(const QRect area);
+    QImage getExportBackground(); // The pixmap without the drawings
+    // With the regions of a huge image or the tiles of the screens, the pixmap
+    // only has the drawings, and it's drawn over the source and them (see
+    // drawDrawnPixmap())
+    bool isDrawingLayer();
+    // The tiles of the screens in one image with the size of the source (only
+    // to export them)
+    QImage getScreenTilesImage();
+    // The area of the pixmap with the drawings, as it's shown (if the pixmap
+    // only has the drawings, they're put over the source or the tiles)
+    QImage getDrawnImage(const QRect area);
+    void imageExported(const QString path, const bool success); // Called when the exporter finished
+    // Streams the encoded image to xclip or wl-copy (called when the exporter
+    // finished encoding it)
+    void pipeToClipboard(const QByteArray bytes, const QString format);
+    void copyToClipboardWithQt(const QByteArray bytes, const QString mimeType);
+    // The image of the clipboard (-c) is fetched with xclip or wl-paste (or Qt
+    // in the other systems) and decoded in the thread pool. A placeholder is
+    // shown in the meantime
+    void fetchClipboardImage(const QString mimeType);
+    QByteArray readClipboardData(const QString mimeType); // With Qt
+    void decodeClipboardImage(const QByteArray bytes);
     void saveFrameToFile(); // Timer function for recording
     void createVideoFFmpeg();
     void saveStateToFile(); // Create a .zoomme file